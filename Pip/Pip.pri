@@ -1,18 +1,63 @@
 HEADERS += \
     $$PWD/PARALLEL_PROCESS.h \
+    $$PWD/captureprofilecache.h \
+    $$PWD/darkregionlocator.h \
+    $$PWD/decodedelaytracker.h \
+    $$PWD/eyecropestimator.h \
+    $$PWD/foreignmat.h \
+    $$PWD/framearchive.h \
+    $$PWD/framearchivepip.h \
+    $$PWD/framebufferpool.h \
+    $$PWD/framegapdetector.h \
+    $$PWD/framereorderbuffer.h \
+    $$PWD/framering.h \
+    $$PWD/glintextractor.h \
+    $$PWD/glinttracker.h \
+    $$PWD/latencyhistogram.h \
     $$PWD/mergedprocessingpip.h \
+    $$PWD/packetrecorder.h \
     $$PWD/parallel_nystagmus_pipline.h \
+    $$PWD/pipelinemetrics.h \
+    $$PWD/pipesignal.h \
     $$PWD/pipline.h \
     $$PWD/pupilextractionpip.h \
+    $$PWD/roipreprocessor.h \
+    $$PWD/roitracker.h \
     $$PWD/rolextractionpip.h \
     $$PWD/spotextractionpip.h \
+    $$PWD/taskscheduler.h \
     $$PWD/videocapturepip.h
 
 SOURCES += \
+    $$PWD/captureprofilecache.cpp \
+    $$PWD/darkregionlocator.cpp \
+    $$PWD/eyecropestimator.cpp \
+    $$PWD/framearchive.cpp \
+    $$PWD/glintextractor.cpp \
+    $$PWD/glinttracker.cpp \
     $$PWD/mergedprocessingpip.cpp \
+    $$PWD/packetrecorder.cpp \
     $$PWD/parallel_nystagmus_pipline.cpp \
+    $$PWD/pipelinemetrics.cpp \
     $$PWD/pipline.cpp \
     $$PWD/pupilextractionpip.cpp \
+    $$PWD/roipreprocessor.cpp \
     $$PWD/rolextractionpip.cpp \
     $$PWD/spotextractionpip.cpp \
+    $$PWD/taskscheduler.cpp \
     $$PWD/videocapturepip.cpp
+
+# libjpeg-turbo 眼部区域解码（qmake CONFIG+=turbojpeg 启用）
+turbojpeg {
+    DEFINES += HAVE_LIBJPEG_TURBO
+    HEADERS += $$PWD/jpegroidecoder.h
+    SOURCES += $$PWD/jpegroidecoder.cpp
+    LIBS += -ljpeg
+}
+
+# Linux 原生 V4L2 采集，其他平台走 FFmpeg
+linux {
+    DEFINES += HAVE_V4L2
+    HEADERS += $$PWD/v4l2capture.h
+    SOURCES += $$PWD/v4l2capture.cpp
+}
@@ -0,0 +1,60 @@
+#include "captureprofilecache.h"
+#include <QDir>
+#include <QSettings>
+#include <QStandardPaths>
+
+namespace {
+    QString settingsPath() {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
+        QDir().mkpath(dir);
+        return dir + "/captureprofiles.ini";
+    }
+}
+
+QString CaptureProfileCache::makeKey(const QString& backend, const QString& device, int width, int height, double fps)
+{
+    // 设备名中的路径分隔符会被 QSettings 当作分组，统一替换掉
+    QString name = device;
+    name.replace('/', '_').replace('\\', '_');
+    return QString("%1/%2@%3x%4@%5").arg(backend, name).arg(width).arg(height).arg(fps, 0, 'f', 2);
+}
+
+bool CaptureProfileCache::load(const QString& key, CaptureProfile& profile)
+{
+    QSettings settings(settingsPath(), QSettings::IniFormat);
+    settings.beginGroup(key);
+    if (!settings.contains("width")) {
+        return false;
+    }
+    CaptureProfile loaded;
+    loaded.codecId = settings.value("codecId", 0).toInt();
+    loaded.pixelFormat = settings.value("pixelFormat", -1).toInt();
+    loaded.width = settings.value("width", 0).toInt();
+    loaded.height = settings.value("height", 0).toInt();
+    loaded.fps = settings.value("fps", 0.0).toDouble();
+    if (!loaded.isValid()) {
+        return false;
+    }
+    profile = loaded;
+    return true;
+}
+
+void CaptureProfileCache::store(const QString& key, const CaptureProfile& profile)
+{
+    QSettings settings(settingsPath(), QSettings::IniFormat);
+    settings.beginGroup(key);
+    settings.setValue("codecId", profile.codecId);
+    settings.setValue("pixelFormat", profile.pixelFormat);
+    settings.setValue("width", profile.width);
+    settings.setValue("height", profile.height);
+    settings.setValue("fps", profile.fps);
+    settings.endGroup();
+    settings.sync();
+}
+
+void CaptureProfileCache::remove(const QString& key)
+{
+    QSettings settings(settingsPath(), QSettings::IniFormat);
+    settings.remove(key);
+    settings.sync();
+}
@@ -0,0 +1,49 @@
+#ifndef CAPTUREPROFILECACHE_H
+#define CAPTUREPROFILECACHE_H
+
+#include <QString>
+
+/**
+ * 摄像头采集参数
+ * FFmpeg 采集时 pixelFormat 为解码输出的 AVPixelFormat；原生 V4L2 采集时为 V4l2Capture::PixelFormat，codecId 为 0。
+ */
+struct CaptureProfile {
+    int codecId = 0;
+    int pixelFormat = -1;
+    int width = 0;
+    int height = 0;
+    double fps = 0;
+
+    bool isValid() const {
+        return width > 0 && height > 0 && pixelFormat >= 0;
+    }
+
+    bool operator==(const CaptureProfile& other) const {
+        return codecId == other.codecId && pixelFormat == other.pixelFormat
+               && width == other.width && height == other.height
+               && qAbs(fps - other.fps) < 0.01;
+    }
+    bool operator!=(const CaptureProfile& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * 摄像头采集参数缓存
+ *
+ * 首次打开时探测/协商得到的参数按 “后端 + 设备身份 + 请求的分辨率和帧率” 保存到 QSettings，
+ * 设备身份由调用方给出（Linux 上为解析后的设备节点加 VIDIOC_QUERYCAP 的 card/bus_info），
+ * 之后打开同一设备时直接使用，跳过 avformat_find_stream_info 的读帧探测和 V4L2 的逐格式协商。
+ * 使用方负责校验：设备报告的参数与缓存不符、或按缓存打开后解不出帧时调用 remove()，下次重新探测。
+ * 每次调用单独打开设置文件，可在任意线程使用；只在打开设备时访问，不在采集循环中调用。
+ */
+class CaptureProfileCache {
+public:
+    static QString makeKey(const QString& backend, const QString& device, int width, int height, double fps);
+
+    static bool load(const QString& key, CaptureProfile& profile);
+    static void store(const QString& key, const CaptureProfile& profile);
+    static void remove(const QString& key);
+};
+
+#endif // CAPTUREPROFILECACHE_H
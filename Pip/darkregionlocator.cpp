@@ -0,0 +1,150 @@
+#include "darkregionlocator.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace {
+    // 最粗一级窗口的最小边长、图像的最小宽高
+    const int MIN_COARSE_WINDOW = 4;
+    const int MIN_COARSE_SIZE = 32;
+    // 逐级细化的搜索半径（该级像素）：上一级 1 像素的误差放大后为 2 像素，再留 1 像素余量
+    const int REFINE_RADIUS = 3;
+
+    inline int levelWindow(int window, int level, const cv::Mat& image) {
+        int w = (window + (1 << level) / 2) >> level;
+        return std::max(1, std::min(w, std::min(image.cols, image.rows)));
+    }
+
+    inline int64_t windowSum(const cv::Mat& integral, int x, int y, int window) {
+        const int* top = integral.ptr<int>(y);
+        const int* bottom = integral.ptr<int>(y + window);
+        return (int64_t)bottom[x + window] - bottom[x] - top[x + window] + top[x];
+    }
+}
+
+bool DarkRegionLocator::locate(const cv::Mat& image, cv::Point& center, double* windowMean, double* imageMean)
+{
+    if (image.empty() || image.type() != CV_8UC1) {
+        return false;
+    }
+
+    // 缩小级数：窗口和图像都不能缩得太小
+    int levels = 0;
+    while ((m_windowSize >> (levels + 1)) >= MIN_COARSE_WINDOW
+           && (image.cols >> (levels + 1)) >= MIN_COARSE_SIZE
+           && (image.rows >> (levels + 1)) >= MIN_COARSE_SIZE) {
+        ++levels;
+    }
+
+    m_pyramid.resize(levels + 1);
+    m_pyramid[0] = image;
+    for (int level = 1; level <= levels; ++level) {
+        const cv::Mat& prev = m_pyramid[level - 1];
+        cv::resize(prev, m_pyramid[level], cv::Size(prev.cols / 2, prev.rows / 2), 0, 0, cv::INTER_AREA);
+    }
+
+    int window = levelWindow(m_windowSize, levels, m_pyramid[levels]);
+    cv::Point topLeft;
+    int64_t bestSum = 0;
+    searchAll(m_pyramid[levels], window, topLeft, bestSum);
+    if (imageMean) {
+        const cv::Mat& coarse = m_pyramid[levels];
+        *imageMean = (double)m_integral.at<int>(coarse.rows, coarse.cols) / ((double)coarse.rows * coarse.cols);
+    }
+
+    for (int level = levels - 1; level >= 0; --level) {
+        // 上一级窗口中心放大 2 倍，换算成本级窗口的左上角
+        int fineWindow = levelWindow(m_windowSize, level, m_pyramid[level]);
+        double cx = (topLeft.x + window * 0.5) * 2;
+        double cy = (topLeft.y + window * 0.5) * 2;
+        cv::Point guess((int)std::lround(cx - fineWindow * 0.5), (int)std::lround(cy - fineWindow * 0.5));
+        window = fineWindow;
+        refine(m_pyramid[level], window, guess, topLeft, bestSum);
+    }
+
+    center = cv::Point(topLeft.x + window / 2, topLeft.y + window / 2);
+    if (windowMean) {
+        *windowMean = (double)bestSum / ((double)window * window);
+    }
+
+    // 不持有调用方的帧，采集端的缓冲区可以及时回收
+    m_pyramid[0].release();
+    return true;
+}
+
+void DarkRegionLocator::searchAll(const cv::Mat& level, int window, cv::Point& topLeft, int64_t& bestSum)
+{
+    // 8 位图像的窗口和：最粗一级窗口很小，int32 不会溢出
+    cv::integral(level, m_integral, CV_32S);
+
+    const int count = level.cols - window + 1;
+    m_rowSums.resize(count);
+    int* sums = m_rowSums.data();
+    int best = INT_MAX;
+    topLeft = cv::Point(0, 0);
+
+    for (int y = 0; y + window <= level.rows; ++y) {
+        const int* top = m_integral.ptr<int>(y);
+        const int* bottom = m_integral.ptr<int>(y + window);
+        int rowMin = INT_MAX;
+        int x = 0;
+#if CV_SIMD
+        const int lanes = cv::v_int32::nlanes;
+        cv::v_int32 vMin = cv::vx_setall_s32(INT_MAX);
+        for (; x <= count - lanes; x += lanes) {
+            cv::v_int32 s = cv::vx_load(bottom + x + window) - cv::vx_load(bottom + x)
+                            - cv::vx_load(top + x + window) + cv::vx_load(top + x);
+            cv::v_store(sums + x, s);
+            vMin = cv::v_min(vMin, s);
+        }
+        rowMin = cv::v_reduce_min(vMin);
+#endif
+        for (; x < count; ++x) {
+            int s = bottom[x + window] - bottom[x] - top[x + window] + top[x];
+            sums[x] = s;
+            rowMin = std::min(rowMin, s);
+        }
+
+        // 只有本行出现更小值时才回头找位置
+        if (rowMin < best) {
+            best = rowMin;
+            for (x = 0; x < count; ++x) {
+                if (sums[x] == rowMin) {
+                    topLeft = cv::Point(x, y);
+                    break;
+                }
+            }
+        }
+    }
+    bestSum = best;
+}
+
+void DarkRegionLocator::refine(const cv::Mat& level, int window, const cv::Point& guess, cv::Point& topLeft, int64_t& bestSum)
+{
+    // 左上角的合法范围与 guess 附近的搜索范围取交集
+    cv::Rect valid(0, 0, level.cols - window + 1, level.rows - window + 1);
+    cv::Rect range = cv::Rect(guess.x - REFINE_RADIUS, guess.y - REFINE_RADIUS,
+                              2 * REFINE_RADIUS + 1, 2 * REFINE_RADIUS + 1) & valid;
+    if (range.empty()) {
+        // guess 落在合法范围外很远（窗口比图像大时才会发生），夹到最近的合法位置
+        range = cv::Rect(std::max(0, std::min(guess.x, valid.width - 1)),
+                         std::max(0, std::min(guess.y, valid.height - 1)), 1, 1);
+    }
+
+    // 只对覆盖所有候选窗口的小块建积分图
+    cv::Rect patch(range.x, range.y, range.width + window - 1, range.height + window - 1);
+    cv::integral(level(patch), m_integral, CV_32S);
+
+    bestSum = INT64_MAX;
+    for (int dy = 0; dy < range.height; ++dy) {
+        for (int dx = 0; dx < range.width; ++dx) {
+            int64_t s = windowSum(m_integral, dx, dy, window);
+            if (s < bestSum) {
+                bestSum = s;
+                topLeft = cv::Point(range.x + dx, range.y + dy);
+            }
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef DARKREGIONLOCATOR_H
+#define DARKREGIONLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 由粗到细的最暗区域定位：找灰度和最小的瞳孔大小的方窗
+ *
+ * 1. 逐级 2 倍面积平均缩小，直到窗口缩到约 4 像素或图像宽度约 32 像素
+ * 2. 最粗一级建积分图，逐行用向量指令计算所有窗口的四角和，取最小者
+ * 3. 逐级放大回原分辨率，每级只在上一级结果（×2）附近 ±3 像素内用局部积分图细化
+ * 原分辨率只参与第一次缩小和最后一级的小范围细化，800x720 的整图定位在 1ms 以内。
+ *
+ * 缩小级和积分图的缓冲区跨帧复用；一个实例只能在一个线程中使用。
+ */
+class DarkRegionLocator {
+public:
+    // 方窗边长（原分辨率像素），取瞳孔直径左右
+    void setWindowSize(int pixels) { m_windowSize = pixels > 2 ? pixels : 2; }
+    int windowSize() const { return m_windowSize; }
+
+    // 返回最暗窗口的中心（image 坐标）；windowMean 为该窗口的平均灰度，imageMean 为整幅图的平均灰度
+    bool locate(const cv::Mat& image, cv::Point& center, double* windowMean = nullptr, double* imageMean = nullptr);
+
+private:
+    // 在整个 level 上搜索边长 window 的方窗，返回灰度和最小者的左上角；m_integral 留下该级的积分图
+    void searchAll(const cv::Mat& level, int window, cv::Point& topLeft, int64_t& bestSum);
+    // 只搜索左上角在 guess 附近 ±3 像素内的方窗
+    void refine(const cv::Mat& level, int window, const cv::Point& guess, cv::Point& topLeft, int64_t& bestSum);
+
+    int m_windowSize = 80;
+    std::vector<cv::Mat> m_pyramid;
+    cv::Mat m_integral;
+    std::vector<int> m_rowSums;
+};
+
+#endif // DARKREGIONLOCATOR_H
@@ -0,0 +1,63 @@
+#ifndef DECODEDELAYTRACKER_H
+#define DECODEDELAYTRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+
+/**
+ * 解码延迟统计：数据包送入解码器 → 对应帧输出的时间
+ *
+ * 送包时按 pts 记下数据包到达时间和采集时间戳，收到帧时按帧的 pts 找回对应记录。
+ * 比它更早、没有产生输出的记录（解码失败、被丢弃）一并清掉。
+ * pts 缺失（AV_NOPTS_VALUE，即 INT64_MIN）时按先进先出对应，MJPEG 这类帧内编码不会重排，结果一致。
+ */
+class DecodeDelayTracker {
+public:
+    static const int64_t NO_PTS = std::numeric_limits<int64_t>::min();
+
+    void packetSent(int64_t pts, int64_t arrivalUs, int64_t captureUs) {
+        if (m_pending.size() >= MAX_PENDING) {
+            m_pending.pop_front();
+        }
+        m_pending.push_back({ pts, arrivalUs, captureUs });
+    }
+
+    // 返回数据包到达 → 帧输出的微秒数，并给出该帧的采集时间戳；对不上时返回 -1，captureUs 不变
+    int64_t frameReceived(int64_t pts, int64_t nowUs, int64_t& captureUs) {
+        if (m_pending.empty()) {
+            return -1;
+        }
+        size_t index = 0;
+        if (pts != NO_PTS) {
+            while (index < m_pending.size() && m_pending[index].pts != pts) {
+                index++;
+            }
+            if (index == m_pending.size()) {
+                return -1;
+            }
+        }
+        Pending matched = m_pending[index];
+        m_pending.erase(m_pending.begin(), m_pending.begin() + index + 1);
+        captureUs = matched.captureUs;
+        return nowUs - matched.arrivalUs;
+    }
+
+    // 解码器刷新（seek、重新打开）后调用
+    void clear() {
+        m_pending.clear();
+    }
+
+private:
+    struct Pending {
+        int64_t pts;
+        int64_t arrivalUs;
+        int64_t captureUs;
+    };
+
+    static const size_t MAX_PENDING = 64;
+    std::deque<Pending> m_pending;
+};
+
+#endif // DECODEDELAYTRACKER_H
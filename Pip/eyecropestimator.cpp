@@ -0,0 +1,145 @@
+#include "eyecropestimator.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // 最暗处的均值低于全图均值的这个比例才认为看到了瞳孔
+    const double DARK_RATIO = 0.6;
+    // 跟踪阶段中心滑动平均的系数，约 10 次定位跟上一次漂移
+    const float SMOOTH_ALPHA = 0.1f;
+    // 平移按 16 像素取整，与 JPEG 的 MCU 对齐，区域解码不必多解半个 MCU
+    const int MOVE_ALIGN = 16;
+
+    float median(std::vector<float> values) {
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        return values[values.size() / 2];
+    }
+}
+
+void EyeCropEstimator::start(const cv::Rect& searchRegion, int warmupFrames, int margin)
+{
+    m_state = CROP_WARMUP_E;
+    m_searchRegion = searchRegion;
+    m_crop = searchRegion;
+    m_warmupFrames = std::max(1, warmupFrames);
+    m_margin = std::max(0, margin);
+    m_frameCount = 0;
+    m_samples.clear();
+    m_samples.reserve(m_warmupFrames);
+}
+
+void EyeCropEstimator::stop()
+{
+    m_state = CROP_IDLE_E;
+    m_samples.clear();
+}
+
+bool EyeCropEstimator::update(const cv::Mat& image, const cv::Point& origin, int scale)
+{
+    if (m_state == CROP_IDLE_E || image.empty()) {
+        return false;
+    }
+    if (m_state == CROP_LOCKED_E && (++m_frameCount % m_trackInterval) != 0) {
+        return false;
+    }
+
+    cv::Point2f center;
+    if (!locate(image, scale, center)) {
+        return false;
+    }
+    center = center * (float)scale + cv::Point2f((float)origin.x, (float)origin.y);
+
+    if (m_state == CROP_WARMUP_E) {
+        m_samples.push_back(center);
+        if ((int)m_samples.size() >= m_warmupFrames) {
+            lock();
+            return true;
+        }
+        return false;
+    }
+    return track(center);
+}
+
+bool EyeCropEstimator::locate(const cv::Mat& image, int scale, cv::Point2f& center)
+{
+    // 窗口取瞳孔直径的一半，落在瞳孔内时均值最低，不被睫毛等细小暗处吸引
+    m_locator.setWindowSize(std::max(3, m_pupilDiameter / (2 * std::max(1, scale))));
+
+    cv::Point darkest;
+    double windowMean = 0;
+    double imageMean = 0;
+    if (!m_locator.locate(image, darkest, &windowMean, &imageMean)) {
+        return false;
+    }
+    if (imageMean <= 0 || windowMean > imageMean * DARK_RATIO) {
+        return false;
+    }
+
+    center = cv::Point2f((float)darkest.x, (float)darkest.y);
+    return true;
+}
+
+void EyeCropEstimator::lock()
+{
+    std::vector<float> xs, ys;
+    xs.reserve(m_samples.size());
+    ys.reserve(m_samples.size());
+    for (const cv::Point2f& p : m_samples) {
+        xs.push_back(p.x);
+        ys.push_back(p.y);
+    }
+    cv::Point2f center(median(xs), median(ys));
+
+    // 离散程度取中位绝对偏差的 3 倍，个别误检不会撑大区域
+    std::vector<float> dx, dy;
+    for (const cv::Point2f& p : m_samples) {
+        dx.push_back(std::abs(p.x - center.x));
+        dy.push_back(std::abs(p.y - center.y));
+    }
+    int halfWidth = (int)std::ceil(3 * median(dx)) + m_margin;
+    int halfHeight = (int)std::ceil(3 * median(dy)) + m_margin;
+
+    cv::Rect crop((int)center.x - halfWidth, (int)center.y - halfHeight, 2 * halfWidth, 2 * halfHeight);
+    crop.width = std::min(crop.width, m_searchRegion.width) & ~1;
+    crop.height = std::min(crop.height, m_searchRegion.height) & ~1;
+    m_crop = clampToSearch(crop);
+    m_smoothedCenter = center;
+    m_frameCount = 0;
+    m_samples.clear();
+    m_state = CROP_LOCKED_E;
+
+    qDebug() << "眼部裁剪区域已确定:" << m_crop.x << m_crop.y << m_crop.width << "x" << m_crop.height
+             << "（搜索区域" << m_searchRegion.width << "x" << m_searchRegion.height << "）";
+}
+
+bool EyeCropEstimator::track(const cv::Point2f& center)
+{
+    m_smoothedCenter += (center - m_smoothedCenter) * SMOOTH_ALPHA;
+
+    cv::Point2f cropCenter(m_crop.x + m_crop.width * 0.5f, m_crop.y + m_crop.height * 0.5f);
+    cv::Point2f offset = m_smoothedCenter - cropCenter;
+    float threshold = std::max(MOVE_ALIGN, m_margin / 4);
+    if (std::abs(offset.x) < threshold && std::abs(offset.y) < threshold) {
+        return false;
+    }
+
+    cv::Rect moved = m_crop;
+    moved.x += (int)std::lround(offset.x / MOVE_ALIGN) * MOVE_ALIGN;
+    moved.y += (int)std::lround(offset.y / MOVE_ALIGN) * MOVE_ALIGN;
+    moved = clampToSearch(moved);
+    if (moved == m_crop) {
+        return false;
+    }
+
+    qDebug() << "眼部裁剪区域跟随漂移:" << m_crop.x << m_crop.y << "->" << moved.x << moved.y;
+    m_crop = moved;
+    return true;
+}
+
+cv::Rect EyeCropEstimator::clampToSearch(cv::Rect rect) const
+{
+    rect.x = std::max(m_searchRegion.x, std::min(rect.x, m_searchRegion.x + m_searchRegion.width - rect.width));
+    rect.y = std::max(m_searchRegion.y, std::min(rect.y, m_searchRegion.y + m_searchRegion.height - rect.height));
+    return rect;
+}
@@ -0,0 +1,69 @@
+#ifndef EYECROPESTIMATOR_H
+#define EYECROPESTIMATOR_H
+
+#include "darkregionlocator.h"
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 采集端眼部裁剪区域估计
+ *
+ * 启动阶段：在搜索区域（setCaptureRoi 设置的区域）内逐帧定位眼睛（瞳孔即画面中最暗的一块），
+ * 累计 warmupFrames 个有效位置后取中位数为中心，按位置的离散程度加边距得到固定大小的裁剪区域。
+ * 跟踪阶段：每隔若干帧在裁剪后的图像上重新定位，中心做慢速滑动平均，
+ * 偏离裁剪中心超过阈值（头部漂移）时整体平移裁剪区域，大小不变，下游图像尺寸保持一致。
+ *
+ * 定位用 DarkRegionLocator 由粗到细搜索半个瞳孔大小的最暗方窗，每次不到 1ms。
+ * 闭眼、眨眼等最暗处不够暗的帧不计入。所有坐标均为原始画面坐标，只在采集线程中使用。
+ */
+class EyeCropEstimator {
+public:
+    typedef enum CROP_STATE_E {
+        CROP_IDLE_E,        // 未启用
+        CROP_WARMUP_E,      // 启动阶段，输出搜索区域
+        CROP_LOCKED_E       // 已确定裁剪区域，跟踪漂移
+    } CROP_STATE_E;
+
+    // 重新开始启动阶段；margin 为眼睛中心到裁剪边界的最小距离（原始像素）
+    void start(const cv::Rect& searchRegion, int warmupFrames = 30, int margin = 300);
+    void stop();
+
+    CROP_STATE_E state() const { return m_state; }
+    bool isWarmingUp() const { return m_state == CROP_WARMUP_E; }
+    bool isLocked() const { return m_state == CROP_LOCKED_E; }
+
+    // 当前应输出的区域：启动阶段为搜索区域，锁定后为裁剪区域
+    cv::Rect crop() const { return m_state == CROP_LOCKED_E ? m_crop : m_searchRegion; }
+
+    // 送入一帧：image 覆盖原始画面中以 origin 为左上角的区域，scale 为 image 相对原始画面的缩小倍数。
+    // 裁剪区域发生变化（锁定或平移）时返回 true
+    bool update(const cv::Mat& image, const cv::Point& origin, int scale = 1);
+
+    // 跟踪阶段每隔多少帧定位一次
+    void setTrackInterval(int frames) { m_trackInterval = frames > 0 ? frames : 1; }
+
+    // 瞳孔的大致直径（原始像素），决定定位窗口的大小
+    void setPupilDiameter(int pixels) { m_pupilDiameter = pixels > 8 ? pixels : 8; }
+
+    // 在灰度图中定位最暗的瞳孔大小区域，返回 image 坐标；没有足够暗的区域时返回 false
+    bool locate(const cv::Mat& image, int scale, cv::Point2f& center);
+
+private:
+    void lock();
+    bool track(const cv::Point2f& center);
+    cv::Rect clampToSearch(cv::Rect rect) const;
+
+    CROP_STATE_E m_state = CROP_IDLE_E;
+    cv::Rect m_searchRegion;
+    cv::Rect m_crop;
+    int m_warmupFrames = 30;
+    int m_margin = 300;
+    int m_trackInterval = 10;
+    int m_pupilDiameter = 80;
+    int m_frameCount = 0;
+    std::vector<cv::Point2f> m_samples;     // 启动阶段的眼睛位置
+    cv::Point2f m_smoothedCenter;           // 跟踪阶段的中心滑动平均
+    DarkRegionLocator m_locator;
+};
+
+#endif // EYECROPESTIMATOR_H
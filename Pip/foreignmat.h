@@ -0,0 +1,75 @@
+#ifndef FOREIGNMAT_H
+#define FOREIGNMAT_H
+
+#include <functional>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 外部内存包装为带引用计数的 cv::Mat
+ *
+ * 驱动缓冲区（V4L2 mmap）、解码器帧等内存不归 OpenCV 管理。
+ * 用 cv::Mat(rows, cols, type, data, step) 包装时没有引用计数，
+ * 无法知道下游何时用完。这里给包装出的 Mat 挂一个自定义 UMatData，
+ * 最后一个持有者释放时调用 release 回调（归还驱动缓冲区/释放解码帧），
+ * 下游照常复制、传递、释放 cv::Mat 即可，不需要任何额外约定。
+ */
+class ForeignMatAllocator : public cv::MatAllocator {
+public:
+    typedef std::function<void()> ReleaseFunc;
+
+    static cv::Mat wrap(int rows, int cols, int type, void* data, size_t step, ReleaseFunc release) {
+        cv::Mat mat(rows, cols, type, data, step);
+
+        cv::UMatData* u = new cv::UMatData(&instance());
+        u->data = u->origdata = static_cast<uchar*>(data);
+        u->size = step * rows;
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+        u->userdata = new ReleaseFunc(std::move(release));
+        u->refcount = 1;
+        u->currAllocator = &instance();
+
+        mat.allocator = &instance();
+        mat.u = u;
+        return mat;
+    }
+
+    // 外部内存不通过本分配器分配
+    cv::UMatData* allocate(int, const int*, int, void*, size_t*,
+                           cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return nullptr;
+    }
+
+    bool allocate(cv::UMatData*, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return false;
+    }
+
+    // cv::Mat 释放最后一个引用时经由 unmap 到达这里
+    void unmap(cv::UMatData* u) const override {
+        if (u->urefcount == 0 && u->refcount == 0) {
+            deallocate(u);
+        }
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) {
+            return;
+        }
+        ReleaseFunc* release = static_cast<ReleaseFunc*>(u->userdata);
+        u->userdata = nullptr;
+        if (release) {
+            if (*release) {
+                (*release)();
+            }
+            delete release;
+        }
+        delete u;
+    }
+
+private:
+    static ForeignMatAllocator& instance() {
+        static ForeignMatAllocator allocator;
+        return allocator;
+    }
+};
+
+#endif // FOREIGNMAT_H
@@ -0,0 +1,212 @@
+#include "framearchive.h"
+#include "foreignmat.h"
+#include <QDebug>
+#include <cstring>
+
+namespace {
+    uint32_t alignUp(uint32_t value, uint32_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+// ==================== 写入 ====================
+
+bool FrameArchiveWriter::open(const QString& path, int width, int height)
+{
+    close();
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "无法创建帧归档文件:" << path;
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_stride = alignUp((uint32_t)width, 64);
+    m_slotSize = alignUp(FrameArchive::RECORD_SIZE + m_stride * (uint32_t)height, 4096);
+    m_slot.assign(m_slotSize, 0);
+    m_written = 0;
+
+    std::vector<char> header(FrameArchive::HEADER_SIZE, 0);
+    FrameArchive::FileHeader fileHeader;
+    memcpy(fileHeader.magic, FrameArchive::MAGIC, sizeof(fileHeader.magic));
+    fileHeader.version = FrameArchive::VERSION;
+    fileHeader.width = width;
+    fileHeader.height = height;
+    fileHeader.stride = m_stride;
+    fileHeader.slotSize = m_slotSize;
+    memcpy(header.data(), &fileHeader, sizeof(fileHeader));
+
+    if (m_file.write(header.data(), header.size()) != (qint64)header.size()) {
+        qWarning() << "写入帧归档文件头失败:" << path;
+        m_file.close();
+        return false;
+    }
+
+    qDebug() << "开始写入帧归档:" << path << width << "x" << height;
+    return true;
+}
+
+void FrameArchiveWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    m_file.close();
+    m_slot.clear();
+    m_slot.shrink_to_fit();
+    qDebug() << "帧归档结束，共" << m_written << "帧";
+}
+
+bool FrameArchiveWriter::append(const cv::Mat& image, int64_t captureTimeUs, int64_t sequence)
+{
+    if (!m_file.isOpen() || image.type() != CV_8UC1
+        || image.cols != m_width || image.rows != m_height) {
+        return false;
+    }
+
+    FrameArchive::FrameRecord record;
+    record.captureTimeUs = captureTimeUs;
+    record.sequence = sequence;
+    memcpy(m_slot.data(), &record, sizeof(record));
+
+    char* pixels = m_slot.data() + FrameArchive::RECORD_SIZE;
+    for (int y = 0; y < m_height; ++y) {
+        memcpy(pixels + (size_t)y * m_stride, image.ptr(y), m_width);
+    }
+
+    if (m_file.write(m_slot.data(), m_slotSize) != (qint64)m_slotSize) {
+        return false;
+    }
+    m_written++;
+    return true;
+}
+
+// ==================== 读取 ====================
+
+// 映射区及其文件，最后一个引用（读取端或取出的图像）释放时解除映射
+struct FrameArchiveReader::Mapping {
+    QFile file;
+    uchar* data = nullptr;
+
+    ~Mapping() {
+        if (data) {
+            file.unmap(data);
+        }
+        file.close();
+    }
+};
+
+bool FrameArchiveReader::open(const QString& path)
+{
+    close();
+
+    std::shared_ptr<Mapping> mapping = std::make_shared<Mapping>();
+    mapping->file.setFileName(path);
+    if (!mapping->file.open(QIODevice::ReadOnly)) {
+        qWarning() << "无法打开帧归档文件:" << path;
+        return false;
+    }
+
+    FrameArchive::FileHeader header;
+    qint64 fileSize = mapping->file.size();
+    bool ok = fileSize >= FrameArchive::HEADER_SIZE
+              && mapping->file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header)
+              && memcmp(header.magic, FrameArchive::MAGIC, sizeof(header.magic)) == 0
+              && header.version == FrameArchive::VERSION
+              && header.width > 0 && header.height > 0
+              && header.stride >= (uint32_t)header.width
+              && header.slotSize >= FrameArchive::RECORD_SIZE + header.stride * (uint32_t)header.height;
+    if (!ok) {
+        qWarning() << "不是帧归档文件或版本不支持:" << path;
+        return false;
+    }
+
+    int64_t frameCount = (fileSize - FrameArchive::HEADER_SIZE) / header.slotSize;
+    if (frameCount > 0) {
+        mapping->data = mapping->file.map(0, FrameArchive::HEADER_SIZE + frameCount * (qint64)header.slotSize);
+        if (!mapping->data) {
+            qWarning() << "帧归档文件映射失败:" << path << mapping->file.errorString();
+            return false;
+        }
+    }
+
+    m_mapping = mapping;
+    m_base = mapping->data;
+    m_width = header.width;
+    m_height = header.height;
+    m_stride = header.stride;
+    m_slotSize = header.slotSize;
+    m_frameCount = frameCount;
+
+    qDebug() << "打开帧归档:" << path << m_width << "x" << m_height << m_frameCount << "帧";
+    return true;
+}
+
+void FrameArchiveReader::close()
+{
+    m_mapping.reset();
+    m_base = nullptr;
+    m_frameCount = 0;
+}
+
+const FrameArchive::FrameRecord* FrameArchiveReader::record(int64_t index) const
+{
+    if (index < 0 || index >= m_frameCount) {
+        return nullptr;
+    }
+    return reinterpret_cast<const FrameArchive::FrameRecord*>(
+        m_base + FrameArchive::HEADER_SIZE + index * (int64_t)m_slotSize);
+}
+
+cv::Mat FrameArchiveReader::frame(int64_t index) const
+{
+    const FrameArchive::FrameRecord* rec = record(index);
+    if (!rec) {
+        return cv::Mat();
+    }
+    uchar* pixels = const_cast<uchar*>(reinterpret_cast<const uchar*>(rec)) + FrameArchive::RECORD_SIZE;
+    std::shared_ptr<Mapping> mapping = m_mapping;
+    return ForeignMatAllocator::wrap(m_height, m_width, CV_8UC1, pixels, m_stride,
+                                     [mapping]() {});
+}
+
+int64_t FrameArchiveReader::captureTimeUs(int64_t index) const
+{
+    const FrameArchive::FrameRecord* rec = record(index);
+    return rec ? rec->captureTimeUs : -1;
+}
+
+int64_t FrameArchiveReader::sequence(int64_t index) const
+{
+    const FrameArchive::FrameRecord* rec = record(index);
+    return rec ? rec->sequence : -1;
+}
+
+int64_t FrameArchiveReader::findFrame(int64_t timeUs) const
+{
+    // 采集时间戳单调递增，二分查找只触及 log2(帧数) 个帧槽
+    int64_t low = 0;
+    int64_t high = m_frameCount;
+    while (low < high) {
+        int64_t mid = low + (high - low) / 2;
+        if (record(mid)->captureTimeUs < timeUs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+int64_t FrameArchiveReader::durationUs() const
+{
+    if (m_frameCount < 2) {
+        return 0;
+    }
+    return captureTimeUs(m_frameCount - 1) - captureTimeUs(0);
+}
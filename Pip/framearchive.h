@@ -0,0 +1,125 @@
+#ifndef FRAMEARCHIVE_H
+#define FRAMEARCHIVE_H
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 预处理帧归档：裁剪后的 8 位灰度眼部图像按固定步长存放，回放时内存映射直接取用
+ *
+ * 与数据包录制（PacketRecorder）不同，这里存的是解码、裁剪之后的结果，
+ * 回放不再解码也不做任何转换，反复调参时整个数据集只需从页缓存读取。
+ *
+ * 文件格式（小端）：
+ *   文件头  占 HEADER_SIZE 字节：magic "NYSFRM01" | uint32 版本 | int32 宽 | int32 高
+ *           | uint32 行步长 | uint32 帧槽大小 | 其余填 0
+ *   帧槽    第 i 帧位于 HEADER_SIZE + i * 帧槽大小：FrameRecord | 高 × 行步长的像素
+ * 帧槽大小固定并按页对齐，帧号即索引，不需要单独的索引表；像素起始地址 64 字节对齐。
+ * 帧数由文件长度推出，写入中断留下的不完整帧槽被忽略。
+ */
+namespace FrameArchive {
+    static const char MAGIC[8] = { 'N', 'Y', 'S', 'F', 'R', 'M', '0', '1' };
+    static const uint32_t VERSION = 1;
+    static const uint32_t HEADER_SIZE = 4096;
+    static const uint32_t RECORD_SIZE = 64;     // 帧记录占用的字节数（含填充）
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        int32_t width;
+        int32_t height;
+        uint32_t stride;
+        uint32_t slotSize;
+    };
+
+    struct FrameRecord {
+        int64_t captureTimeUs;  // 采集时间戳（steady_clock 微秒）
+        int64_t sequence;       // 驱动帧序号，未知为 -1
+    };
+}
+
+/**
+ * 写入端：帧尺寸在打开时确定，之后每帧尺寸必须一致。
+ * 在采集线程中同步写入，一帧只有一次拷贝和一次 write，落盘由系统页缓存完成。
+ */
+class FrameArchiveWriter {
+public:
+    FrameArchiveWriter() {}
+    ~FrameArchiveWriter() { close(); }
+
+    FrameArchiveWriter(const FrameArchiveWriter&) = delete;
+    FrameArchiveWriter& operator=(const FrameArchiveWriter&) = delete;
+
+    bool open(const QString& path, int width, int height);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    // 追加一帧 CV_8UC1 图像，尺寸不符或写入失败时返回 false
+    bool append(const cv::Mat& image, int64_t captureTimeUs, int64_t sequence);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    uint64_t framesWritten() const { return m_written; }
+
+private:
+    QFile m_file;
+    int m_width = 0;
+    int m_height = 0;
+    uint32_t m_stride = 0;
+    uint32_t m_slotSize = 0;
+    std::vector<char> m_slot;   // 整个帧槽先拼好再一次写出
+    uint64_t m_written = 0;
+};
+
+/**
+ * 读取端：整个文件只读映射，frame() 返回直接指向映射区的 cv::Mat，不拷贝。
+ * 返回的图像持有映射的引用，close() 或对象析构后仍然有效，最后一个持有者释放时才解除映射；
+ * 图像只读（写入会触发 SIGSEGV），交给会修改图像的下游前必须拷贝，frameArchivePip 拷进缓冲池后再送出。
+ * 打开后各成员只读，可在多个线程中同时取帧。
+ */
+class FrameArchiveReader {
+public:
+    FrameArchiveReader() {}
+    ~FrameArchiveReader() { close(); }
+
+    FrameArchiveReader(const FrameArchiveReader&) = delete;
+    FrameArchiveReader& operator=(const FrameArchiveReader&) = delete;
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_mapping != nullptr; }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int64_t frameCount() const { return m_frameCount; }
+
+    // 第 index 帧，越界时返回空
+    cv::Mat frame(int64_t index) const;
+    int64_t captureTimeUs(int64_t index) const;
+    int64_t sequence(int64_t index) const;
+
+    // 采集时间戳不早于 timeUs 的第一帧，全部更早时返回 frameCount()
+    int64_t findFrame(int64_t timeUs) const;
+
+    // 首末帧采集时间戳之差（微秒）
+    int64_t durationUs() const;
+
+private:
+    struct Mapping;
+
+    const FrameArchive::FrameRecord* record(int64_t index) const;
+
+    std::shared_ptr<Mapping> m_mapping;
+    const uchar* m_base = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    uint32_t m_stride = 0;
+    uint32_t m_slotSize = 0;
+    int64_t m_frameCount = 0;
+};
+
+#endif // FRAMEARCHIVE_H
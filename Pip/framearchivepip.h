@@ -0,0 +1,232 @@
+#ifndef FRAMEARCHIVEPIP_H
+#define FRAMEARCHIVEPIP_H
+
+#include <QElapsedTimer>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "pipline.h"
+#include "framearchive.h"
+#include "framebufferpool.h"
+#include "framegapdetector.h"
+#include "sharedpipelinedate.h"
+
+/**
+ * 帧归档源：从内存映射的预处理帧归档（FrameArchiveWriter 写出）取帧送入管道，
+ * 可替代 videoCapturePip 作为第 0 级。
+ *
+ * 映射区只读，而下游（eyeTrack 的显示）会在 FrameData::originalImage 上直接绘制，
+ * 因此每帧拷进缓冲池的 slab 再送出（一次 memcpy，不解码、不裁剪、不分配）；可随机定位到任意帧或时间点。
+ * 默认按录制时间戳的间隔送帧；不限速时由下游处理速度决定节奏且不丢帧，用于反复调参。
+ */
+class frameArchivePip : public QObject, public AbstractPipe
+{
+    Q_OBJECT
+public:
+    frameArchivePip() : QObject(), AbstractPipe("FrameArchivePipe", PIPE_SOURCE_E) {}
+
+    bool open(const QString& path) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bool ok = m_reader.open(path);
+        m_position = 0;
+        m_ready = ok && m_reader.frameCount() > 0;
+        m_stateSignal.notifyAll();
+        return ok;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ready = false;
+        m_reader.close();
+    }
+
+    int64_t frameCount() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_reader.frameCount();
+    }
+
+    // 下一帧的序号
+    int64_t position() const {
+        return m_position;
+    }
+
+    // 定位到第 index 帧，下一次送帧生效；正在等待送帧时立即打断
+    void seek(int64_t index) {
+        m_seekIndex = index < 0 ? 0 : index;
+        m_stateSignal.notifyAll();
+    }
+
+    // 定位到距第一帧 offsetUs 微秒处
+    void seekToTime(int64_t offsetUs) {
+        int64_t index;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            index = m_reader.findFrame(m_reader.captureTimeUs(0) + offsetUs);
+        }
+        seek(index);
+    }
+
+    // 不限速：不按时间戳等待，输出队列满时等待下游而不丢帧
+    void setUnthrottled(bool enabled) {
+        m_unthrottled = enabled;
+    }
+
+    // 播放到结尾后是否从头开始；不循环时结束后发出 archiveFinished()
+    void setLoop(bool enabled) {
+        m_loop = enabled;
+    }
+
+    void pipe(QSemaphore& inSem, QSemaphore& outSem) override {
+        Q_UNUSED(inSem);
+
+        LatencyHistogram& fetchHist = stepHistogram("fetch");
+        LatencyHistogram& paceHist = stepHistogram("pace");
+        std::atomic<uint64_t>& frameCounter = stageCounter("frames");
+        std::atomic<uint64_t>& outDropCounter = stageCounter("outputDropped");
+
+        // 按录制时间戳送帧：以一帧为基准对齐时间，定位、回到开头、暂停或间隔过长时重新对齐
+        int64_t baseCaptureUs = -1;
+        int64_t baseWallUs = 0;
+
+        QElapsedTimer runTimer;
+        runTimer.start();
+        int runFrames = 0;
+        bool finished = false;
+
+        while (!exit()) {
+            if (m_paused || !m_ready) {
+                m_stateSignal.wait([this]() { return (!m_paused && m_ready) || exit(); });
+                baseCaptureUs = -1;
+                continue;
+            }
+
+            int64_t seekTo = m_seekIndex.exchange(-1);
+            if (seekTo >= 0) {
+                m_position = seekTo;
+                baseCaptureUs = -1;
+                m_gapDetector.reset();
+            }
+
+            QElapsedTimer fetchTimer;
+            fetchTimer.start();
+            cv::Mat image;
+            int64_t captureUs = -1;
+            int64_t sequence = -1;
+            bool atEnd = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_position >= m_reader.frameCount()) {
+                    atEnd = true;
+                } else {
+                    // 映射区的视图只作为拷贝源，不交给下游
+                    cv::Mat mapped = m_reader.frame(m_position);
+                    if (!mapped.empty()) {
+                        image = m_framePool.acquire(mapped.rows, mapped.cols, mapped.type());
+                        mapped.copyTo(image);
+                    }
+                    captureUs = m_reader.captureTimeUs(m_position);
+                    sequence = m_reader.sequence(m_position);
+                }
+            }
+            if (atEnd) {
+                if (!m_loop) {
+                    finished = true;
+                    break;
+                }
+                m_position = 0;
+                baseCaptureUs = -1;
+                m_gapDetector.reset();
+                continue;
+            }
+            double fetchTime = fetchTimer.nsecsElapsed() / 1e6;
+
+            if (!m_unthrottled) {
+                QElapsedTimer paceTimer;
+                paceTimer.start();
+                int64_t nowUs = steadyNowUs();
+                int64_t dueUs = baseWallUs + (captureUs - baseCaptureUs);
+                if (baseCaptureUs < 0 || captureUs < baseCaptureUs || dueUs - nowUs > 1000000) {
+                    baseCaptureUs = captureUs;
+                    baseWallUs = nowUs;
+                } else if (dueUs > nowUs) {
+                    // 等待期间被定位/暂停/退出打断时放弃本帧，回到循环开头处理
+                    bool interrupted = m_stateSignal.waitFor(
+                        [this]() { return exit() || m_paused || m_seekIndex >= 0; },
+                        std::chrono::microseconds(dueUs - nowUs));
+                    if (interrupted) {
+                        continue;
+                    }
+                }
+                paceHist.recordMs(paceTimer.nsecsElapsed() / 1e6);
+            }
+
+            int frameId = SharedPipelineData::generateFrameId();
+            SharedPipelineData::createFrameData(frameId, image);
+            SharedPipelineData::setTime(frameId, 1, fetchTime);
+            FrameTiming timing = m_gapDetector.update(captureUs, sequence);
+
+            PipeFrame outFrame;
+            outFrame.frameId = frameId;
+            outFrame.image = image;
+            outFrame.captureTimeUs = captureUs;
+            outFrame.sequence = sequence;
+            outFrame.intervalUs = timing.intervalUs;
+            outFrame.droppedBefore = timing.droppedBefore;
+
+            fetchHist.recordMs(fetchTime);
+            frameCounter.fetch_add(1, std::memory_order_relaxed);
+            m_position++;
+            runFrames++;
+
+            if (m_unthrottled) {
+                if (!pushOutFrameWait(std::move(outFrame), outSem)) {
+                    break;
+                }
+            } else if (!pushOutFrame(std::move(outFrame), outSem)) {
+                outDropCounter.fetch_add(1, std::memory_order_relaxed);
+            }
+            sendOverSign(frameId);
+        }
+
+        if (finished) {
+            double wallSeconds = runTimer.nsecsElapsed() / 1e9;
+            double mediaSeconds;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                mediaSeconds = m_reader.durationUs() / 1e6;
+            }
+            qDebug() << QString("帧归档处理完毕: %1 帧, 耗时 %2 s").arg(runFrames).arg(wallSeconds, 0, 'f', 2);
+            if (wallSeconds > 0) {
+                qDebug() << QString("  - 吞吐: %1 fps").arg(runFrames / wallSeconds, 0, 'f', 1);
+                if (mediaSeconds > 0) {
+                    qDebug() << QString("  - 相对录制时长: %1x").arg(mediaSeconds / wallSeconds, 0, 'f', 2);
+                }
+            }
+            qDebug().noquote() << metrics().report();
+            emit archiveFinished();
+        }
+    }
+
+signals:
+    void sendOverSign(int frameId);
+    // 不循环时播放到结尾，送帧线程已退出
+    void archiveFinished();
+
+private:
+    static int64_t steadyNowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    FrameArchiveReader m_reader;
+    FrameGapDetector m_gapDetector;         // 归档帧之间的间隔（录制时的丢帧）
+    FrameBufferPool m_framePool;            // 送出帧的可写缓冲区，下游释放后复用
+    std::mutex m_mutex;                     // 保护 m_reader 的打开/关闭与取帧
+    std::atomic<bool> m_ready{false};       // 已打开且至少有一帧
+    std::atomic<int64_t> m_position{0};
+    std::atomic<int64_t> m_seekIndex{-1};
+    std::atomic<bool> m_unthrottled{false};
+    std::atomic<bool> m_loop{true};
+};
+
+#endif // FRAMEARCHIVEPIP_H
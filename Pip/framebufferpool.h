@@ -0,0 +1,100 @@
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 固定尺寸的帧缓冲池
+ *
+ * - 预先分配若干同尺寸同类型的 cv::Mat（slab），池本身始终持有一份引用
+ * - acquire() 取出一个只被池引用的 slab；使用方照常传递/释放 cv::Mat，
+ *   最后一个持有者释放后引用计数回到 1，slab 自动回到可用状态
+ * - 所有 slab 都被占用时临时扩容并计数，稳态下扩容次数应为 0
+ *
+ * 尺寸或类型变化时整体重建，旧 slab 由仍在使用的持有者自然释放。
+ */
+class FrameBufferPool {
+public:
+    FrameBufferPool() {}
+
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+    // 按几何参数取一个空闲缓冲区，几何参数变化时自动重建池
+    cv::Mat acquire(int rows, int cols, int type) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (rows != m_rows || cols != m_cols || type != m_type) {
+            rebuild(rows, cols, type);
+        }
+
+        const size_t count = m_slabs.size();
+        for (size_t i = 0; i < count; ++i) {
+            size_t index = (m_next + i) % count;
+            if (isFree(m_slabs[index])) {
+                m_next = (index + 1) % count;
+                return m_slabs[index];
+            }
+        }
+
+        // 全部被占用：扩容（下游持有帧的时间超出了池容量）
+        m_slabs.emplace_back(m_rows, m_cols, m_type);
+        m_growCount++;
+        return m_slabs.back();
+    }
+
+    // 预分配的 slab 数量，下次重建时生效
+    void setInitialSlabs(size_t count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_initialSlabs = count > 0 ? count : 1;
+    }
+
+    size_t slabCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_slabs.size();
+    }
+
+    // 因池耗尽而额外分配的次数
+    uint64_t growCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_growCount;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_slabs.clear();
+        m_rows = m_cols = m_type = -1;
+        m_next = 0;
+    }
+
+private:
+    static bool isFree(const cv::Mat& slab) {
+        // 只有池自己持有时引用计数为 1；用原子读避免与其他线程的释放竞争
+        return slab.u && CV_XADD(&slab.u->refcount, 0) == 1;
+    }
+
+    void rebuild(int rows, int cols, int type) {
+        m_slabs.clear();
+        m_rows = rows;
+        m_cols = cols;
+        m_type = type;
+        m_next = 0;
+        m_slabs.reserve(m_initialSlabs * 2);
+        for (size_t i = 0; i < m_initialSlabs; ++i) {
+            m_slabs.emplace_back(rows, cols, type);
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::vector<cv::Mat> m_slabs;
+    int m_rows = -1;
+    int m_cols = -1;
+    int m_type = -1;
+    size_t m_next = 0;
+    size_t m_initialSlabs = 8;
+    uint64_t m_growCount = 0;
+};
+
+#endif // FRAMEBUFFERPOOL_H
@@ -0,0 +1,99 @@
+#ifndef FRAMEGAPDETECTOR_H
+#define FRAMEGAPDETECTOR_H
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * 帧的时间信息：采集时间戳之外，记录与上一帧的实际间隔以及两帧之间丢失的帧数
+ */
+struct FrameTiming {
+    int64_t captureTimeUs = 0;  // 采集时间戳（steady_clock 基准，微秒）
+    int64_t intervalUs = 0;     // 与上一帧采集时间戳之差，第一帧为 0
+    int droppedBefore = 0;      // 与上一帧之间丢失的帧数
+    bool duplicate = false;     // 与上一帧是同一帧（序号或时间戳未前进）
+};
+
+/**
+ * 丢帧/重复帧检测
+ *
+ * 有驱动帧序号（V4L2）时按序号的跳变判断，最准确；
+ * 没有序号（FFmpeg 源）时按时间戳间隔与标称帧间隔之比判断，间隔超过 1.5 倍即认为中间丢了帧。
+ * 标称间隔未设置时取稳定间隔的滑动平均估计。只在采集线程中使用。
+ */
+class FrameGapDetector {
+public:
+    // 标称帧率，<= 0 表示根据间隔自动估计
+    void setNominalFps(double fps) {
+        m_nominalIntervalUs = fps > 0 ? 1e6 / fps : 0;
+        m_fixedNominal = fps > 0;
+    }
+
+    FrameTiming update(int64_t captureTimeUs, int64_t sequence) {
+        FrameTiming timing;
+        timing.captureTimeUs = captureTimeUs;
+
+        // 时间戳倒退（回放回到开头、设备重开）视为新的开始，不与之前的帧比较
+        if (m_lastTimeUs >= 0 && captureTimeUs >= m_lastTimeUs) {
+            timing.intervalUs = captureTimeUs - m_lastTimeUs;
+
+            if (sequence >= 0 && m_lastSequence >= 0 && sequence >= m_lastSequence) {
+                int64_t step = sequence - m_lastSequence;
+                timing.duplicate = (step == 0);
+                timing.droppedBefore = step > 1 ? (int)(step - 1) : 0;
+            } else if (timing.intervalUs == 0) {
+                timing.duplicate = true;
+            } else if (m_nominalIntervalUs > 0) {
+                double ratio = timing.intervalUs / m_nominalIntervalUs;
+                if (ratio < 0.25) {
+                    timing.duplicate = true;
+                } else if (ratio > 1.5) {
+                    timing.droppedBefore = (int)std::lround(ratio) - 1;
+                }
+            }
+
+            // 正常间隔才参与标称间隔估计，丢帧造成的长间隔不计入
+            if (!m_fixedNominal && !timing.duplicate && timing.droppedBefore == 0 && timing.intervalUs > 0) {
+                m_nominalIntervalUs = m_nominalIntervalUs > 0
+                        ? m_nominalIntervalUs * 0.95 + timing.intervalUs * 0.05
+                        : (double)timing.intervalUs;
+            }
+        }
+
+        m_lastTimeUs = captureTimeUs;
+        m_lastSequence = sequence;
+        m_droppedFrames += timing.droppedBefore;
+        if (timing.droppedBefore > 0) {
+            m_gapEvents++;
+        }
+        if (timing.duplicate) {
+            m_duplicateFrames++;
+        }
+        return timing;
+    }
+
+    // 源重新打开、定位或回到开头后调用，下一帧不与之前的帧比较
+    void reset() {
+        m_lastTimeUs = -1;
+        m_lastSequence = -1;
+        if (!m_fixedNominal) {
+            m_nominalIntervalUs = 0;
+        }
+    }
+
+    double nominalIntervalUs() const { return m_nominalIntervalUs; }
+    uint64_t droppedFrames() const { return m_droppedFrames; }
+    uint64_t duplicateFrames() const { return m_duplicateFrames; }
+    uint64_t gapEvents() const { return m_gapEvents; }
+
+private:
+    double m_nominalIntervalUs = 0;
+    bool m_fixedNominal = false;
+    int64_t m_lastTimeUs = -1;
+    int64_t m_lastSequence = -1;
+    uint64_t m_droppedFrames = 0;
+    uint64_t m_duplicateFrames = 0;
+    uint64_t m_gapEvents = 0;
+};
+
+#endif // FRAMEGAPDETECTOR_H
@@ -0,0 +1,104 @@
+#ifndef FRAMEREORDERBUFFER_H
+#define FRAMEREORDERBUFFER_H
+
+#include <deque>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * 帧重排序缓冲
+ *
+ * 多个 worker 并行处理帧时，完成顺序与派发顺序不一致。
+ * 派发时按顺序登记 frameId，完成后填入结果，drain() 按派发顺序输出。
+ *
+ * 延迟预算：队首帧超过预算仍未完成、而其后已有帧完成时，
+ * 放弃等待队首帧（计为迟到帧），它之后的完成结果会被丢弃，
+ * 保证输出始终按 frameId 单调递增。
+ *
+ * 本类不加锁，由调用方保证互斥。
+ */
+template <typename T>
+class FrameReorderBuffer {
+public:
+    // latencyBudgetMs <= 0 表示无限等待
+    void reset(double latencyBudgetMs) {
+        m_pending.clear();
+        m_latencyBudgetMs = latencyBudgetMs;
+        m_lateFrames = 0;
+    }
+
+    // 按派发顺序登记
+    void expect(int frameId) {
+        Entry entry;
+        entry.frameId = frameId;
+        entry.dispatchTime = std::chrono::steady_clock::now();
+        m_pending.push_back(std::move(entry));
+    }
+
+    // 填入处理结果；返回 false 表示该帧已因超出预算被放弃
+    bool complete(int frameId, T &&value) {
+        for (auto &entry : m_pending) {
+            if (entry.frameId == frameId) {
+                entry.value = std::move(value);
+                entry.done = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 按登记顺序输出所有可输出的结果
+    template <typename EmitFunc>
+    void drain(EmitFunc &&emit) {
+        while (!m_pending.empty()) {
+            Entry &front = m_pending.front();
+            if (front.done) {
+                emit(front.frameId, front.value);
+                m_pending.pop_front();
+                continue;
+            }
+            if (!frontExpired() || !hasCompletedBehindFront()) {
+                break;
+            }
+            // 队首帧超出延迟预算，跳过它
+            m_lateFrames++;
+            m_pending.pop_front();
+        }
+    }
+
+    bool empty() const { return m_pending.empty(); }
+    size_t pendingCount() const { return m_pending.size(); }
+    uint64_t lateFrames() const { return m_lateFrames; }
+
+private:
+    struct Entry {
+        int frameId = -1;
+        bool done = false;
+        T value{};
+        std::chrono::steady_clock::time_point dispatchTime;
+    };
+
+    bool frontExpired() const {
+        if (m_latencyBudgetMs <= 0) {
+            return false;
+        }
+        double waitedMs = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - m_pending.front().dispatchTime).count();
+        return waitedMs > m_latencyBudgetMs;
+    }
+
+    bool hasCompletedBehindFront() const {
+        for (size_t i = 1; i < m_pending.size(); ++i) {
+            if (m_pending[i].done) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::deque<Entry> m_pending;
+    double m_latencyBudgetMs = 0;
+    uint64_t m_lateFrames = 0;
+};
+
+#endif // FRAMEREORDERBUFFER_H
@@ -0,0 +1,149 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 管道级间的帧环形队列
+ *
+ * - 单生产者/单消费者（SPSC），无锁
+ * - 容量可配置（向上取整为2的幂）
+ * - 读写索引按缓存行对齐，避免伪共享
+ * - 槽位内保存的是“拥有所有权”的帧，出队即转移，不再需要 clone()
+ */
+
+#ifndef PIPE_CACHE_LINE_SIZE
+#define PIPE_CACHE_LINE_SIZE 64
+#endif
+
+// 级间传递的帧记录
+struct PipeFrame {
+    int frameId = -1;
+    cv::Mat image;      // 帧图像（引用计数，所有权随出入队转移）
+    int64_t captureTimeUs = 0;  // 采集时间戳（steady_clock 基准，微秒；V4L2 源为内核缓冲区时间戳）
+    int64_t sequence = -1;      // 驱动帧序号，未知时为 -1
+    int64_t intervalUs = 0;     // 与上一帧的实际采集间隔（微秒），第一帧为 0
+    int droppedBefore = 0;      // 与上一帧之间丢失的帧数（采集端检测）
+    cv::Point cropOrigin;       // image 左上角在原始画面中的坐标（采集端裁剪区域随头部漂移平移）
+};
+
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity = 4) {
+        reset(capacity);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // 重新分配容量，只能在生产者和消费者线程都未运行时调用
+    void reset(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        m_slots.reset(new T[cap]);
+        m_capacity = cap;
+        m_mask = cap - 1;
+        m_head.value.store(0, std::memory_order_relaxed);
+        m_tail.value.store(0, std::memory_order_relaxed);
+        m_dropped.store(0, std::memory_order_relaxed);
+    }
+
+    // 丢弃所有未消费的元素，同样只能在两端线程停止后调用
+    void clear() {
+        while (tryPop()) {}
+    }
+
+    // 生产者调用：队列满时返回 false，不阻塞
+    bool tryPush(T&& item) {
+        const size_t head = m_head.value.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.value.load(std::memory_order_acquire);
+        if (head - tail >= m_capacity) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_slots[head & m_mask] = std::move(item);
+        m_head.value.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 生产者调用：队列满时等待消费者腾出空位（离线回放的背压），stop() 成立时放弃并返回 false。
+    // 只有在有生产者等待时 tryPop 才会加锁通知，tryPush/tryPop 的无锁路径不受影响
+    template <typename StopPredicate>
+    bool pushWait(T&& item, StopPredicate stop) {
+        while (!stop()) {
+            if (size() < m_capacity) {
+                const size_t head = m_head.value.load(std::memory_order_relaxed);
+                m_slots[head & m_mask] = std::move(item);
+                m_head.value.store(head + 1, std::memory_order_release);
+                return true;
+            }
+            std::unique_lock<std::mutex> lock(m_spaceMutex);
+            m_spaceWaiters.fetch_add(1);
+            // 超时兜底：stop() 的状态变化不会通知本条件变量
+            m_spaceCond.wait_for(lock, std::chrono::milliseconds(5),
+                                 [this, &stop]() { return size() < m_capacity || stop(); });
+            m_spaceWaiters.fetch_sub(1);
+        }
+        return false;
+    }
+
+    // 消费者调用：队列空时返回 false
+    bool tryPop(T& out) {
+        const size_t tail = m_tail.value.load(std::memory_order_relaxed);
+        const size_t head = m_head.value.load(std::memory_order_acquire);
+        if (tail == head) {
+            return false;
+        }
+        out = std::move(m_slots[tail & m_mask]);
+        m_slots[tail & m_mask] = T();   // 立即释放槽位持有的资源
+        m_tail.value.store(tail + 1, std::memory_order_release);
+        if (m_spaceWaiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_spaceMutex);
+            m_spaceCond.notify_one();
+        }
+        return true;
+    }
+
+    bool tryPop() {
+        T discard;
+        return tryPop(discard);
+    }
+
+    size_t size() const {
+        return m_head.value.load(std::memory_order_acquire) - m_tail.value.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return m_capacity; }
+
+    // 因队列满被丢弃的帧数
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(PIPE_CACHE_LINE_SIZE) PaddedIndex {
+        std::atomic<size_t> value{0};
+    };
+
+    PaddedIndex m_head;     // 生产者写
+    PaddedIndex m_tail;     // 消费者写
+    alignas(PIPE_CACHE_LINE_SIZE) std::unique_ptr<T[]> m_slots;
+    size_t m_capacity = 0;
+    size_t m_mask = 0;
+    std::atomic<uint64_t> m_dropped{0};
+
+    std::atomic<int> m_spaceWaiters{0};     // pushWait 中等待的生产者数
+    std::mutex m_spaceMutex;
+    std::condition_variable m_spaceCond;
+};
+
+typedef SpscRing<PipeFrame> FrameRing;
+
+#endif // FRAMERING_H
@@ -0,0 +1,163 @@
+#include "glintextractor.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // 跳过整段为 0 的 8 字节，光斑二值图绝大部分是背景
+    inline int skipZeros(const uchar* row, int x, int width) {
+        while (x + 8 <= width) {
+            uint64_t word;
+            std::memcpy(&word, row + x, sizeof(word));
+            if (word != 0) {
+                break;
+            }
+            x += 8;
+        }
+        while (x < width && row[x] == 0) {
+            ++x;
+        }
+        return x;
+    }
+
+    inline int skipOnes(const uchar* row, int x, int width) {
+        while (x < width && row[x] != 0) {
+            ++x;
+        }
+        return x;
+    }
+}
+
+std::vector<Circle> GlintExtractor::extract(const cv::Mat& binary, const cv::Point& darkPoint)
+{
+    std::vector<Circle> circles;
+    if (binary.empty() || binary.type() != CV_8UC1) {
+        return circles;
+    }
+
+    const int width = binary.cols;
+    m_prevRuns.clear();
+    m_parent.clear();
+    m_stats.clear();
+
+    for (int y = 0; y < binary.rows; ++y) {
+        const uchar* row = binary.ptr<uchar>(y);
+        m_currRuns.clear();
+        size_t prev = 0;
+
+        int x = skipZeros(row, 0, width);
+        while (x < width) {
+            int start = x;
+            int end = skipOnes(row, x, width);
+
+            // 8 邻域：上一行游程 [s, e) 与本行 [start, end) 在 s <= end && e >= start 时相连。
+            // 上一行游程按列有序，结束于 start 之前的不会再与本行后面的游程相连
+            while (prev < m_prevRuns.size() && m_prevRuns[prev].end < start) {
+                ++prev;
+            }
+            int label = -1;
+            for (size_t i = prev; i < m_prevRuns.size() && m_prevRuns[i].start <= end; ++i) {
+                int root = findRoot(m_prevRuns[i].label);
+                label = label < 0 ? root : unite(label, root);
+            }
+            if (label < 0) {
+                label = newLabel();
+            }
+            addRun(label, y, start, end);
+            m_currRuns.push_back(Run{start, end, label});
+
+            x = skipZeros(row, end, width);
+        }
+        std::swap(m_prevRuns, m_currRuns);
+    }
+
+    // 只有根保存完整的统计量
+    m_accepted.clear();
+    const double maxDistance2 = m_maxDistance * m_maxDistance;
+    for (int label = 0; label < (int)m_parent.size(); ++label) {
+        if (m_parent[label] != label) {
+            continue;
+        }
+        const BlobStats& s = m_stats[label];
+        if (s.area < m_minArea || s.area > m_maxArea) {
+            continue;
+        }
+        if (m_maxDistance > 0) {
+            double dx = (double)s.sumX / s.area - darkPoint.x;
+            double dy = (double)s.sumY / s.area - darkPoint.y;
+            if (dx * dx + dy * dy > maxDistance2) {
+                continue;
+            }
+        }
+        m_accepted.push_back(label);
+    }
+
+    if ((int)m_accepted.size() > m_maxCount) {
+        std::partial_sort(m_accepted.begin(), m_accepted.begin() + m_maxCount, m_accepted.end(),
+                          [this](int a, int b) { return m_stats[a].area > m_stats[b].area; });
+        m_accepted.resize(m_maxCount);
+    }
+
+    circles.reserve(m_accepted.size());
+    for (int label : m_accepted) {
+        const BlobStats& s = m_stats[label];
+        Circle circle;
+        circle.center = cv::Point2f((float)((double)s.sumX / s.area), (float)((double)s.sumY / s.area));
+        circle.radius = std::max(s.maxX - s.minX + 1, s.maxY - s.minY + 1) * 0.5f;
+        circles.push_back(circle);
+    }
+    return circles;
+}
+
+int GlintExtractor::newLabel()
+{
+    int label = (int)m_parent.size();
+    m_parent.push_back(label);
+    m_stats.push_back(BlobStats{0, 0, 0, INT32_MAX, INT32_MAX, -1, -1});
+    return label;
+}
+
+int GlintExtractor::findRoot(int label)
+{
+    // 路径减半
+    while (m_parent[label] != label) {
+        m_parent[label] = m_parent[m_parent[label]];
+        label = m_parent[label];
+    }
+    return label;
+}
+
+int GlintExtractor::unite(int a, int b)
+{
+    if (a == b) {
+        return a;
+    }
+    // 保留较小的标号为根，统计量并入根
+    if (b < a) {
+        std::swap(a, b);
+    }
+    m_parent[b] = a;
+    BlobStats& root = m_stats[a];
+    const BlobStats& child = m_stats[b];
+    root.area += child.area;
+    root.sumX += child.sumX;
+    root.sumY += child.sumY;
+    root.minX = std::min(root.minX, child.minX);
+    root.minY = std::min(root.minY, child.minY);
+    root.maxX = std::max(root.maxX, child.maxX);
+    root.maxY = std::max(root.maxY, child.maxY);
+    return a;
+}
+
+void GlintExtractor::addRun(int label, int y, int start, int end)
+{
+    BlobStats& s = m_stats[label];
+    int length = end - start;
+    s.area += length;
+    // start..end-1 的列号之和
+    s.sumX += (int64_t)(start + end - 1) * length / 2;
+    s.sumY += (int64_t)y * length;
+    s.minX = std::min(s.minX, start);
+    s.maxX = std::max(s.maxX, end - 1);
+    s.minY = std::min(s.minY, y);
+    s.maxY = std::max(s.maxY, y);
+}
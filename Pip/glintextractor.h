@@ -0,0 +1,74 @@
+#ifndef GLINTEXTRACTOR_H
+#define GLINTEXTRACTOR_H
+
+#include "class.h"
+#include <cstdint>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 光斑提取：在光斑二值图上做单遍的游程连通域标记
+ *
+ * 逐行把非零像素切成游程，与上一行的游程按 8 邻域比较重叠，用并查集合并标号；
+ * 面积、坐标和、外接矩形随游程累加到并查集的根上，合并时把统计量并入新根。
+ * 不生成轮廓点集，不为单个光斑分配内存，整幅 ROI 只读一遍，复杂度 O(像素数)。
+ *
+ * 输出与 SpotExtraction::lightExpection 同为 Circle 列表（ROI 坐标），但不保证逐项相同：
+ * center 为像素质心，radius 取外接矩形长边的一半（近似最小外接圆），
+ * 过滤条件只有面积和到暗点的距离。后续的修补与排列仍交给 SmartSpotProcessor 和 arrangeSpots。
+ * 因此各级默认仍用 lightExpection，需要时通过 setFastGlintExtraction 显式开启。
+ *
+ * 游程和统计量的缓冲区跨帧复用；一个实例只能在一个线程中使用。
+ */
+class GlintExtractor {
+public:
+    // 光斑面积范围（像素），超出的连通域（噪点、眼睑反光）丢弃
+    void setAreaRange(int minArea, int maxArea) {
+        m_minArea = minArea > 1 ? minArea : 1;
+        m_maxArea = maxArea > m_minArea ? maxArea : m_minArea;
+    }
+
+    // 质心到暗点的最大距离（像素），<= 0 表示不限制
+    void setMaxDistance(double pixels) { m_maxDistance = pixels; }
+
+    // 最多返回的光斑数，按面积从大到小保留
+    void setMaxCount(int count) { m_maxCount = count > 0 ? count : 1; }
+
+    // binary 为 CV_8UC1 二值图（非零即光斑）；darkPoint 为 binary 坐标的暗点
+    std::vector<Circle> extract(const cv::Mat& binary, const cv::Point& darkPoint);
+
+private:
+    struct Run {
+        int start;      // 起始列
+        int end;        // 结束列（不含）
+        int label;
+    };
+
+    struct BlobStats {
+        int area;
+        int64_t sumX;
+        int64_t sumY;
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+    int newLabel();
+    int findRoot(int label);
+    int unite(int a, int b);
+    void addRun(int label, int y, int start, int end);
+
+    int m_minArea = 2;
+    int m_maxArea = 400;
+    double m_maxDistance = 0;
+    int m_maxCount = 16;
+
+    std::vector<Run> m_prevRuns;
+    std::vector<Run> m_currRuns;
+    std::vector<int> m_parent;
+    std::vector<BlobStats> m_stats;
+    std::vector<int> m_accepted;
+};
+
+#endif // GLINTEXTRACTOR_H
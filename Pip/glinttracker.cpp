@@ -0,0 +1,184 @@
+#include "glinttracker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // 单个光斑位移与四个光斑平均位移之差的容差（像素）
+    const float GEOMETRY_TOLERANCE = 3.0f;
+    // 参与质心的最少像素数，再少说明窗口里没有光斑
+    const int MIN_GLINT_PIXELS = 2;
+
+    inline float length(const cv::Point2f& p) {
+        return std::sqrt(p.x * p.x + p.y * p.y);
+    }
+}
+
+void GlintTracker::setEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_enabled = enabled;
+    m_valid = false;
+}
+
+bool GlintTracker::isEnabled() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_enabled;
+}
+
+void GlintTracker::setRefreshInterval(int frames)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_refreshInterval = frames;
+}
+
+void GlintTracker::setWindowRadius(int pixels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_windowRadius = std::max(3, pixels);
+}
+
+void GlintTracker::setIntensityThreshold(int value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threshold = std::max(0, std::min(254, value));
+}
+
+bool GlintTracker::measure(int frameId, const cv::Mat& image, const cv::Point& origin, std::vector<Circle>& spots)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_enabled || !m_valid || image.empty() || image.type() != CV_8UC1
+        || (m_refreshInterval > 0 && frameId - m_lastDetectFrameId >= m_refreshInterval)) {
+        m_detectedFrames.fetch_add(1, std::memory_order_relaxed);
+        m_lastDetectFrameId = frameId;
+        return false;
+    }
+
+    // 帧级并行时上一帧的结果可能还没出来，按实际相隔的帧数外推
+    int gap = std::max(1, frameId - m_lastFrameId);
+    cv::Point2f shift = m_velocity * (float)gap;
+    cv::Point2f offset((float)origin.x, (float)origin.y);
+    int radius = m_windowRadius + (int)std::ceil(length(shift));
+    cv::Rect bounds(0, 0, image.cols, image.rows);
+
+    cv::Point2f predicted[GLINT_COUNT];
+    cv::Point2f measured[GLINT_COUNT];
+    int counts[GLINT_COUNT];
+    cv::Point2f meanMove(0, 0);
+    for (int i = 0; i < GLINT_COUNT; ++i) {
+        predicted[i] = m_positions[i] + shift - offset;
+        cv::Point c((int)std::lround(predicted[i].x), (int)std::lround(predicted[i].y));
+        cv::Rect window = cv::Rect(c.x - radius, c.y - radius, 2 * radius + 1, 2 * radius + 1) & bounds;
+        if (window.empty() || !weightedCentroid(image, window, m_threshold, measured[i], counts[i])) {
+            return fallBack(frameId);
+        }
+        meanMove += measured[i] - predicted[i];
+    }
+    meanMove *= 1.0f / GLINT_COUNT;
+
+    // 几何确认：整体平移之外的残差都要小，且没有两个窗口锁到同一个光斑上
+    for (int i = 0; i < GLINT_COUNT; ++i) {
+        if (length(measured[i] - predicted[i] - meanMove) > GEOMETRY_TOLERANCE) {
+            return fallBack(frameId);
+        }
+        for (int j = i + 1; j < GLINT_COUNT; ++j) {
+            if (length(measured[i] - measured[j]) < m_windowRadius) {
+                return fallBack(frameId);
+            }
+        }
+    }
+
+    spots.resize(GLINT_COUNT);
+    for (int i = 0; i < GLINT_COUNT; ++i) {
+        spots[i].center = measured[i];
+        // 半径沿用排列时的结果，亮像素数只作为兜底
+        spots[i].radius = m_radius[i] > 0 ? m_radius[i] : std::sqrt(counts[i] / (float)CV_PI);
+    }
+    m_trackedFrames.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void GlintTracker::reportSuccess(int frameId, const std::vector<Circle>& arranged, const cv::Point& origin)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_enabled || (int)arranged.size() < GLINT_COUNT || (m_valid && frameId <= m_lastFrameId)) {
+        return;
+    }
+
+    cv::Point2f offset((float)origin.x, (float)origin.y);
+    cv::Point2f move(0, 0);
+    for (int i = 0; i < GLINT_COUNT; ++i) {
+        cv::Point2f position = arranged[i].center + offset;
+        move += position - m_positions[i];
+        m_positions[i] = position;
+        m_radius[i] = arranged[i].radius;
+    }
+
+    if (m_valid) {
+        int gap = std::max(1, frameId - m_lastFrameId);
+        cv::Point2f velocity = move * (1.0f / (GLINT_COUNT * gap));
+        // 速度平滑一下，单帧的测量抖动不放大窗口
+        m_velocity = m_velocity * 0.5f + velocity * 0.5f;
+    } else {
+        m_velocity = cv::Point2f(0, 0);
+    }
+    m_lastFrameId = frameId;
+    m_valid = true;
+}
+
+void GlintTracker::reportFailure(int frameId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_valid && frameId >= m_lastFrameId) {
+        markLost();
+    }
+}
+
+void GlintTracker::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_valid = false;
+    m_lastFrameId = -1;
+    m_lastDetectFrameId = -1;
+}
+
+bool GlintTracker::weightedCentroid(const cv::Mat& image, const cv::Rect& window, int threshold,
+                                    cv::Point2f& center, int& count) const
+{
+    // 权重为超出阈值的灰度，光斑边缘的过渡像素按亮度参与，得到亚像素质心
+    int64_t sumW = 0;
+    int64_t sumX = 0;
+    int64_t sumY = 0;
+    count = 0;
+    for (int y = window.y; y < window.y + window.height; ++y) {
+        const uchar* row = image.ptr<uchar>(y);
+        for (int x = window.x; x < window.x + window.width; ++x) {
+            int w = row[x] - threshold;
+            if (w > 0) {
+                sumW += w;
+                sumX += (int64_t)w * x;
+                sumY += (int64_t)w * y;
+                ++count;
+            }
+        }
+    }
+    if (count < MIN_GLINT_PIXELS || sumW == 0) {
+        return false;
+    }
+    center = cv::Point2f((float)((double)sumX / sumW), (float)((double)sumY / sumW));
+    return true;
+}
+
+void GlintTracker::markLost()
+{
+    m_valid = false;
+    m_lostEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool GlintTracker::fallBack(int frameId)
+{
+    markLost();
+    m_detectedFrames.fetch_add(1, std::memory_order_relaxed);
+    m_lastDetectFrameId = frameId;
+    return false;
+}
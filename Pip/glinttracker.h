@@ -0,0 +1,79 @@
+#ifndef GLINTTRACKER_H
+#define GLINTTRACKER_H
+
+#include "class.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 四个角膜反射光斑的帧间跟踪
+ *
+ * 四个光斑随眼球整体平移，相对位置几乎不变。跟踪上以后不再对整幅 ROI 做连通域提取和排列：
+ * 按上一帧的位置加公共速度预测每个光斑，在预测点周围的小窗口里对高于阈值的灰度求加权质心，
+ * 一帧只读四个窗口（几百个像素）。
+ * 光斑身份按几何关系确认：四个测量位移与平均位移的偏差都要在容差内、两两之间不能挤到一起，
+ * 因此输出顺序与上一帧的 arrangedSpots 一致。任一光斑测量失败或几何不符即判定跟丢，
+ * 由调用方退回整幅提取 + arrangeSpots，排列成功后再用 reportSuccess 重新开始跟踪。
+ *
+ * 位置按原始画面坐标保存，与 RoiTracker 一样不受采集端裁剪平移和 ROI 位置变化影响。
+ * 帧级并行时多个 worker 共用一个实例，所有接口加锁；乱序到达的旧帧结果被忽略。
+ */
+class GlintTracker {
+public:
+    static const int GLINT_COUNT = 4;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // 每隔多少帧强制做一次整幅提取，<= 0 表示不强制
+    void setRefreshInterval(int frames);
+
+    // 测量窗口半径（像素）与加权阈值（模糊图灰度），阈值以下的像素不参与质心
+    void setWindowRadius(int pixels);
+    void setIntensityThreshold(int value);
+
+    // image 为未修补光斑的模糊图，其左上角位于原始画面 origin 处。
+    // 成功时 spots 为 image 坐标的四个光斑，顺序与上一帧的排列结果相同；返回 false 表示需要整幅提取
+    bool measure(int frameId, const cv::Mat& image, const cv::Point& origin, std::vector<Circle>& spots);
+
+    // 排列完成的光斑（坐标系左上角位于原始画面 origin 处），作为下一帧的预测起点
+    void reportSuccess(int frameId, const std::vector<Circle>& arranged, const cv::Point& origin);
+
+    // 光斑排列失败，下一帧回到整幅提取
+    void reportFailure(int frameId);
+
+    void reset();
+
+    uint64_t trackedFrames() const { return m_trackedFrames.load(std::memory_order_relaxed); }
+    uint64_t detectedFrames() const { return m_detectedFrames.load(std::memory_order_relaxed); }
+    uint64_t lostEvents() const { return m_lostEvents.load(std::memory_order_relaxed); }
+
+private:
+    // 单个窗口内的加权质心，count 为参与的像素数
+    bool weightedCentroid(const cv::Mat& image, const cv::Rect& window, int threshold,
+                          cv::Point2f& center, int& count) const;
+    void markLost();
+    // 本帧跟丢，计为一次整幅提取
+    bool fallBack(int frameId);
+
+    mutable std::mutex m_mutex;
+    bool m_enabled = false;
+    bool m_valid = false;
+    int m_refreshInterval = 300;
+    int m_windowRadius = 8;
+    int m_threshold = 200;
+    int m_lastFrameId = -1;
+    int m_lastDetectFrameId = -1;
+    cv::Point2f m_positions[GLINT_COUNT];   // 原始画面坐标
+    float m_radius[GLINT_COUNT] = {};
+    cv::Point2f m_velocity;                 // 四个光斑的公共速度，像素/帧
+
+    std::atomic<uint64_t> m_trackedFrames{0};
+    std::atomic<uint64_t> m_detectedFrames{0};
+    std::atomic<uint64_t> m_lostEvents{0};
+};
+
+#endif // GLINTTRACKER_H
@@ -0,0 +1,143 @@
+#include "jpegroidecoder.h"
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+struct JpegRoiDecoder::Impl {
+    struct ErrorManager {
+        jpeg_error_mgr pub;
+        jmp_buf jump;
+    };
+
+    jpeg_decompress_struct cinfo;
+    ErrorManager error;
+
+    // 致命错误跳回 setjmp 处，由调用方中止本帧
+    static void onError(j_common_ptr cinfo) {
+        ErrorManager* error = reinterpret_cast<ErrorManager*>(cinfo->err);
+        longjmp(error->jump, 1);
+    }
+
+    // MJPEG 常见的轻微损坏只产生警告，不输出到终端
+    static void onMessage(j_common_ptr) {}
+
+    Impl() {
+        cinfo.err = jpeg_std_error(&error.pub);
+        error.pub.error_exit = &Impl::onError;
+        error.pub.output_message = &Impl::onMessage;
+        jpeg_create_decompress(&cinfo);
+    }
+
+    ~Impl() {
+        jpeg_destroy_decompress(&cinfo);
+    }
+};
+
+JpegRoiDecoder::JpegRoiDecoder()
+    : m_impl(new Impl())
+{
+}
+
+JpegRoiDecoder::~JpegRoiDecoder()
+{
+}
+
+bool JpegRoiDecoder::decode(const uint8_t* data, size_t size, cv::Mat& out)
+{
+    if (!data || size == 0) {
+        return false;
+    }
+
+    cv::Rect region;
+    int bufferWidth = 0;
+    int columnOffset = 0;
+    if (!beginDecode(data, size, region, bufferWidth, columnOffset)) {
+        return false;
+    }
+
+    // 裁剪后的扫描线从 MCU 边界开始，左侧多出 columnOffset 列，输出时只取视图
+    cv::Mat buffer = m_pool.acquire(region.height, bufferWidth, CV_8UC1);
+    if (!readRows(buffer.data, buffer.step, region.y, region.height)) {
+        return false;
+    }
+
+    out = buffer(cv::Rect(columnOffset, 0, region.width, region.height));
+    return true;
+}
+
+bool JpegRoiDecoder::beginDecode(const uint8_t* data, size_t size, cv::Rect& region,
+                                 int& bufferWidth, int& columnOffset)
+{
+    jpeg_decompress_struct& cinfo = m_impl->cinfo;
+    if (setjmp(m_impl->error.jump)) {
+        jpeg_abort_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_mem_src(&cinfo, data, (unsigned long)size);
+    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+        jpeg_abort_decompress(&cinfo);
+        return false;
+    }
+
+    cinfo.out_color_space = JCS_GRAYSCALE;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = m_scaleDenom;
+    jpeg_start_decompress(&cinfo);
+
+    // ROI 换算到缩放后的输出坐标，向外取整保证覆盖原 ROI
+    const int denom = m_scaleDenom;
+    const int outWidth = cinfo.output_width;
+    const int outHeight = cinfo.output_height;
+    int x0 = 0, y0 = 0, x1 = outWidth, y1 = outHeight;
+    if (m_roi.area() > 0) {
+        x0 = std::max(0, m_roi.x / denom);
+        y0 = std::max(0, m_roi.y / denom);
+        x1 = std::min(outWidth, (m_roi.x + m_roi.width + denom - 1) / denom);
+        y1 = std::min(outHeight, (m_roi.y + m_roi.height + denom - 1) / denom);
+    }
+    if (x1 <= x0 || y1 <= y0) {
+        jpeg_abort_decompress(&cinfo);
+        return false;
+    }
+
+    // 只解码覆盖 ROI 的 MCU 列，库会把起点对齐到 MCU 边界并相应加宽
+    JDIMENSION cropX = x0;
+    JDIMENSION cropWidth = x1 - x0;
+    if ((int)cropWidth < outWidth) {
+        jpeg_crop_scanline(&cinfo, &cropX, &cropWidth);
+    }
+
+    // ROI 上方的行只做熵解码，不做 IDCT
+    if (y0 > 0) {
+        jpeg_skip_scanlines(&cinfo, y0);
+    }
+
+    region = cv::Rect(x0, y0, x1 - x0, y1 - y0);
+    bufferWidth = cinfo.output_width;
+    columnOffset = x0 - (int)cropX;
+    return true;
+}
+
+bool JpegRoiDecoder::readRows(uint8_t* dst, size_t step, int firstRow, int rowCount)
+{
+    jpeg_decompress_struct& cinfo = m_impl->cinfo;
+    if (setjmp(m_impl->error.jump)) {
+        jpeg_abort_decompress(&cinfo);
+        return false;
+    }
+
+    const JDIMENSION lastRow = firstRow + rowCount;
+    while (cinfo.output_scanline < lastRow) {
+        JSAMPROW row = dst + (size_t)(cinfo.output_scanline - firstRow) * step;
+        if (jpeg_read_scanlines(&cinfo, &row, 1) != 1) {
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+    }
+
+    // ROI 下方的行不再解码，直接中止，解码对象留给下一帧复用
+    jpeg_abort_decompress(&cinfo);
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef JPEGROIDECODER_H
+#define JPEGROIDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <opencv2/core/core.hpp>
+#include "framebufferpool.h"
+
+/**
+ * 基于 libjpeg-turbo 的眼部区域 MJPEG 解码
+ *
+ * - 直接输出灰度（只做 Y 分量的 IDCT，不处理色度）
+ * - jpeg_skip_scanlines 跳过 ROI 上方的行，读完 ROI 下边界即中止，下方的行不解码
+ * - jpeg_crop_scanline 只解码覆盖 ROI 左右边界的 MCU 列
+ * - 可选 1/2、1/4、1/8 DCT 域缩放，缩放后输出坐标按比例缩小，由调用方换算
+ * - 解码器状态跨帧复用，输出缓冲来自缓冲池；UVC 摄像头省略的 Huffman 表由库使用标准表补齐
+ *
+ * 单线程使用：一个实例只能在一个线程里解码。
+ */
+class JpegRoiDecoder {
+public:
+    JpegRoiDecoder();
+    ~JpegRoiDecoder();
+
+    JpegRoiDecoder(const JpegRoiDecoder&) = delete;
+    JpegRoiDecoder& operator=(const JpegRoiDecoder&) = delete;
+
+    // 原图坐标下的 ROI，空矩形表示整帧；超出画面的部分自动裁掉
+    void setRoi(const cv::Rect& roi) { m_roi = roi; }
+    cv::Rect roi() const { return m_roi; }
+
+    // DCT 缩放分母：1（不缩放）、2、4、8，其他值按 1 处理
+    void setScaleDenom(int denom) {
+        m_scaleDenom = (denom == 2 || denom == 4 || denom == 8) ? denom : 1;
+    }
+    int scaleDenom() const { return m_scaleDenom; }
+
+    // 解码一帧 JPEG，out 为 ROI（缩放后）的灰度图；数据损坏时返回 false
+    bool decode(const uint8_t* data, size_t size, cv::Mat& out);
+
+private:
+    struct Impl;    // libjpeg 解码对象和错误处理，头文件不暴露 jpeglib.h
+
+    // 以下两步各自 setjmp，栈上不放带析构的对象
+    bool beginDecode(const uint8_t* data, size_t size, cv::Rect& region, int& bufferWidth, int& columnOffset);
+    bool readRows(uint8_t* dst, size_t step, int firstRow, int rowCount);
+
+    std::unique_ptr<Impl> m_impl;
+    cv::Rect m_roi;
+    int m_scaleDenom = 1;
+    FrameBufferPool m_pool;
+};
+
+#endif // JPEGROIDECODER_H
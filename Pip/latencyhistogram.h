@@ -0,0 +1,155 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * 无锁延迟直方图（HDR 风格的对数-线性分桶）
+ *
+ * - 以纳秒记录，每个 2 的幂区间再等分为 32 个子桶，相对误差约 3%
+ * - 覆盖 0 ~ 约 36 分钟，超出部分计入最后一个桶
+ * - record() 只有几次 relaxed 原子操作，可在多个线程中同时调用
+ * - 百分位在读取时由桶计数累加得到，读取与写入并发时结果是近似快照
+ */
+class LatencyHistogram {
+public:
+    struct Snapshot {
+        uint64_t count = 0;
+        double meanMs = 0;
+        double p50Ms = 0;
+        double p99Ms = 0;
+        double p999Ms = 0;
+        double maxMs = 0;
+    };
+
+    LatencyHistogram() { reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void recordNs(int64_t ns) {
+        uint64_t value = ns > 0 ? (uint64_t)ns : 0;
+        m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sumNs.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t prevMax = m_maxNs.load(std::memory_order_relaxed);
+        while (value > prevMax &&
+               !m_maxNs.compare_exchange_weak(prevMax, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void recordMs(double ms) {
+        recordNs((int64_t)(ms * 1e6));
+    }
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+    // q 取值 0~1，返回毫秒（桶中点）
+    double percentileMs(double q) const {
+        uint64_t counts[BUCKET_COUNT];
+        uint64_t total = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        return percentileFromCounts(counts, total, q);
+    }
+
+    Snapshot snapshot() const {
+        uint64_t counts[BUCKET_COUNT];
+        uint64_t total = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        Snapshot snap;
+        snap.count = total;
+        if (total == 0) {
+            return snap;
+        }
+        snap.meanMs = m_sumNs.load(std::memory_order_relaxed) / 1e6 / total;
+        snap.p50Ms = percentileFromCounts(counts, total, 0.50);
+        snap.p99Ms = percentileFromCounts(counts, total, 0.99);
+        snap.p999Ms = percentileFromCounts(counts, total, 0.999);
+        snap.maxMs = m_maxNs.load(std::memory_order_relaxed) / 1e6;
+        return snap;
+    }
+
+    // 与 record() 并发调用时，少量样本可能落在清零前后的任一侧
+    void reset() {
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            m_buckets[i].store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_sumNs.store(0, std::memory_order_relaxed);
+        m_maxNs.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static const int SUB_BITS = 5;
+    static const int SUB_COUNT = 1 << SUB_BITS;       // 每个 2 的幂区间的子桶数
+    static const int MAX_EXPONENT = 36;               // 上限 2^41 ns ≈ 36 分钟
+    static const int BUCKET_COUNT = (MAX_EXPONENT + 1) * SUB_COUNT;
+
+    static int highestBit(uint64_t value) {
+        int bit = 0;
+        while (value >>= 1) {
+            bit++;
+        }
+        return bit;
+    }
+
+    static int bucketIndex(uint64_t value) {
+        if (value < (uint64_t)SUB_COUNT) {
+            return (int)value;
+        }
+        int exponent = highestBit(value) - SUB_BITS + 1;
+        if (exponent > MAX_EXPONENT) {
+            return BUCKET_COUNT - 1;
+        }
+        return exponent * SUB_COUNT + (int)(value >> (exponent - 1)) - SUB_COUNT;
+    }
+
+    // 桶的下界和宽度（纳秒）
+    static void bucketRange(int index, double& lower, double& width) {
+        if (index < SUB_COUNT) {
+            lower = index;
+            width = 1;
+            return;
+        }
+        int exponent = index / SUB_COUNT;
+        int sub = index % SUB_COUNT + SUB_COUNT;
+        width = (double)((uint64_t)1 << (exponent - 1));
+        lower = sub * width;
+    }
+
+    static double percentileFromCounts(const uint64_t* counts, uint64_t total, double q) {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(q * total);
+        if (rank >= total) {
+            rank = total - 1;
+        }
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts[i];
+            if (seen > rank) {
+                double lower, width;
+                bucketRange(i, lower, width);
+                return (lower + width / 2) / 1e6;
+            }
+        }
+        return 0;
+    }
+
+    std::atomic<uint64_t> m_buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sumNs;
+    std::atomic<uint64_t> m_maxNs;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -2,7 +2,9 @@
 
 MergedProcessingPip::MergedProcessingPip() :
     QObject(),
-    AbstractPipe("MergedProcessingPipe", PIPE_PROCESS_E)
+    AbstractPipe("MergedProcessingPipe", PIPE_PROCESS_E),
+    m_roiTracker(std::make_shared<RoiTracker>()),
+    m_glintTracker(std::make_shared<GlintTracker>())
 {
     // 初始化所有处理组件
     rolExtraction = new RolExtraction();
@@ -28,29 +30,34 @@ MergedProcessingPip::~MergedProcessingPip() {
 
 // ===  主管道函数 ===
 void MergedProcessingPip::pipe(QSemaphore& inSem, QSemaphore& outSem) {
-    FrameImage* pInFrame = (FrameImage*)m_pInImage;
-    FrameImage* pOutFrame = (FrameImage*)m_pOutImage;
     int lastProcessedFrameId = -1;
 
     // 创建失败图像保存目录
-    QString saveDir = "failed_frames";
     QDir dir;
-    if (!dir.exists(saveDir)) {
-        if (!dir.mkpath(saveDir)) {
-            qWarning() << "无法创建失败帧保存目录:" << saveDir;
+    if (!dir.exists(m_failedFrameDir)) {
+        if (!dir.mkpath(m_failedFrameDir)) {
+            qWarning() << "无法创建失败帧保存目录:" << m_failedFrameDir;
         } else {
-            qDebug() << "创建失败帧保存目录:" << saveDir;
+            qDebug() << "创建失败帧保存目录:" << m_failedFrameDir;
         }
     }
 
+    bindMetrics();
+    if (m_workerCount > 1) {
+        pipeParallel(inSem, outSem);
+        return;
+    }
+
     while (!exit()) {
-        inSem.acquire();
-        if (pInFrame && !pInFrame->image.empty()) {
-            int frameId = pInFrame->frameId;
+        PipeFrame inFrame;
+        if (!popInFrame(inSem, inFrame)) {
+            continue;
+        }
+        if (!inFrame.image.empty()) {
+            int frameId = inFrame.frameId;
             // 防止处理重复帧
             if (frameId == lastProcessedFrameId) {
                 qWarning() << "MergedProcessingPip: 检测到重复帧" << frameId;
-                outSem.release();
                 continue;
             }
             lastProcessedFrameId = frameId;
@@ -58,62 +65,186 @@ void MergedProcessingPip::pipe(QSemaphore& inSem, QSemaphore& outSem) {
             QElapsedTimer totalTimer;
             totalTimer.start();
 
-            cv::Mat src = pInFrame->image.clone();
-            SharedPipelineData::createFrameData(frameId, src);
-
-            // 执行完整的处理流程
-            bool success = processFrameComplete(frameId);
-
-            if (!success) {
-                qDebug() << "帧：" << frameId << "失败";
-
-                // 保存失败的原始图像到本地
-                try {
-                    // 生成文件名：failed_frame_[frameId]_[timestamp].jpg
-                    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss_zzz");
-                    QString filename = QString("failed_frame_%1_%2.jpg").arg(frameId).arg(timestamp);
-                    QString fullPath = QDir(saveDir).absoluteFilePath(filename);
-
-                    // 转换QString到std::string
-                    std::string stdPath = fullPath.toStdString();
-
-                    // 保存图像
-                    if (cv::imwrite(stdPath, src)) {
-                        qDebug() << "失败帧已保存:" << fullPath;
-                        qDebug() << "图像尺寸:" << src.cols << "x" << src.rows
-                                 << "通道数:" << src.channels() << "类型:" << src.type();
-                    } else {
-                        qWarning() << "保存失败帧失败:" << fullPath;
-                    }
-
-                } catch (const cv::Exception& e) {
-                    qWarning() << "保存失败帧时发生OpenCV异常:" << e.what();
-                } catch (const std::exception& e) {
-                    qWarning() << "保存失败帧时发生异常:" << e.what();
-                } catch (...) {
-                    qWarning() << "保存失败帧时发生未知异常";
-                }
-            }
+            // 出队的帧归本级独占，上游不会再写入，无需 clone
+            bool success = processInputFrame(frameId, inFrame.image, inFrame.cropOrigin);
 
             double totalTime = totalTimer.nsecsElapsed() / 1e6;
             // SharedPipelineData::setTime(frameId, 2, totalTime);
+            m_totalHist->recordMs(totalTime);
 
             // 发送信号
             emit processingComplete(frameId, success);
-            emit sendOverSign(pInFrame->frameId);
+            emit sendOverSign(frameId);
+            pushOutFrame(std::move(inFrame), outSem);
+        }
+    }
+}
+
+// === 🔧 单帧入口：登记帧数据、执行处理、保存失败帧 ===
+bool MergedProcessingPip::processInputFrame(int frameId, const cv::Mat& src, const cv::Point& cropOrigin) {
+    SharedPipelineData::createFrameData(frameId, src);
+
+    // 执行完整的处理流程
+    bool success = processFrameComplete(frameId, cropOrigin);
+    (success ? m_successCounter : m_failureCounter)->fetch_add(1, std::memory_order_relaxed);
+
+    if (!success) {
+        qDebug() << "帧：" << frameId << "失败";
+
+        // 保存失败的原始图像到本地
+        try {
+            // 生成文件名：failed_frame_[frameId]_[timestamp].jpg
+            QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss_zzz");
+            QString filename = QString("failed_frame_%1_%2.jpg").arg(frameId).arg(timestamp);
+            QString fullPath = QDir(m_failedFrameDir).absoluteFilePath(filename);
+
+            // 转换QString到std::string
+            std::string stdPath = fullPath.toStdString();
+
+            // 保存图像
+            if (cv::imwrite(stdPath, src)) {
+                qDebug() << "失败帧已保存:" << fullPath;
+                qDebug() << "图像尺寸:" << src.cols << "x" << src.rows
+                         << "通道数:" << src.channels() << "类型:" << src.type();
+            } else {
+                qWarning() << "保存失败帧失败:" << fullPath;
+            }
+
+        } catch (const cv::Exception& e) {
+            qWarning() << "保存失败帧时发生OpenCV异常:" << e.what();
+        } catch (const std::exception& e) {
+            qWarning() << "保存失败帧时发生异常:" << e.what();
+        } catch (...) {
+            qWarning() << "保存失败帧时发生未知异常";
+        }
+    }
+
+    return success;
+}
+
+// === 🔧 帧级并行 ===
+void MergedProcessingPip::setParallelWorkers(int workerCount, double latencyBudgetMs) {
+    m_workerCount = std::max(1, workerCount);
+    m_latencyBudgetMs = latencyBudgetMs;
+
+    m_workers.clear();
+    m_idleWorkers.clear();
+    if (m_workerCount > 1) {
+        for (int i = 0; i < m_workerCount; ++i) {
+            std::unique_ptr<MergedProcessingPip> worker(new MergedProcessingPip());
+            worker->setMappingCoefficients(m_mappingCoefficients);
+            worker->setCombinedMappingCoefficients(combinedMappingCoefficients);
+            worker->debugFlag = debugFlag;
+            worker->setIntraFrameThreads(m_intraFrameThreads);
+            worker->m_roiTracker = m_roiTracker;
+            worker->m_glintTracker = m_glintTracker;
+            worker->setFastDarkLocator(m_fastDarkLocator, darkLocator.windowSize());
+            worker->setFastGlintExtraction(m_fastGlintExtraction);
+            m_idleWorkers.push_back(worker.get());
+            m_workers.push_back(std::move(worker));
+        }
+    }
+
+    qDebug() << "MergedProcessingPip: 并行worker数" << m_workerCount
+             << "延迟预算" << m_latencyBudgetMs << "ms";
+}
+
+MergedProcessingPip* MergedProcessingPip::takeWorker() {
+    QMutexLocker locker(&m_workerMutex);
+    MergedProcessingPip* worker = m_idleWorkers.back();
+    m_idleWorkers.pop_back();
+    return worker;
+}
+
+void MergedProcessingPip::pipeParallel(QSemaphore& inSem, QSemaphore& outSem) {
+    QThreadPool pool;
+    pool.setMaxThreadCount(m_workerCount);
+    m_workerSlots.acquire(m_workerSlots.available());
+    m_workerSlots.release(m_workerCount);
+    {
+        QMutexLocker locker(&m_reorderMutex);
+        m_reorder.reset(m_latencyBudgetMs);
+        m_lateFrames = 0;
+    }
+
+    int lastDispatchedFrameId = -1;
+    while (!exit()) {
+        PipeFrame inFrame;
+        if (!popInFrame(inSem, inFrame)) {
+            continue;
+        }
+        if (inFrame.image.empty()) {
+            continue;
+        }
+        int frameId = inFrame.frameId;
+        if (frameId == lastDispatchedFrameId) {
+            qWarning() << "MergedProcessingPip: 检测到重复帧" << frameId;
+            continue;
+        }
+        lastDispatchedFrameId = frameId;
+
+        // 所有 worker 忙时在此等待，上游队列满后由采集端丢帧
+        m_workerSlots.acquire();
+        MergedProcessingPip* worker = takeWorker();
+        {
+            QMutexLocker locker(&m_reorderMutex);
+            m_reorder.expect(frameId);
         }
-        outSem.release();
+
+        auto frame = std::make_shared<PipeFrame>(std::move(inFrame));
+        pool.start([this, worker, frameId, frame, &outSem]() {
+            QElapsedTimer totalTimer;
+            totalTimer.start();
+            ParallelResult result;
+            result.success = worker->processInputFrame(frameId, frame->image, frame->cropOrigin);
+            m_totalHist->recordMs(totalTimer.nsecsElapsed() / 1e6);
+            result.frame = std::move(*frame);
+            {
+                QMutexLocker locker(&m_workerMutex);
+                m_idleWorkers.push_back(worker);
+            }
+            m_workerSlots.release();
+            completeParallelFrame(frameId, std::move(result), outSem);
+        });
+    }
+
+    // 退出前等待在途帧完成并按序发出
+    pool.waitForDone();
+    QMutexLocker locker(&m_reorderMutex);
+    m_reorder.drain([this, &outSem](int frameId, ParallelResult& result) {
+        emit processingComplete(frameId, result.success);
+        emit sendOverSign(frameId);
+        pushOutFrame(std::move(result.frame), outSem);
+    });
+}
+
+void MergedProcessingPip::completeParallelFrame(int frameId, ParallelResult&& result, QSemaphore& outSem) {
+    // 在锁内按序发出信号，保证下游（预测器）看到的 frameId 单调递增
+    QMutexLocker locker(&m_reorderMutex);
+    if (!m_reorder.complete(frameId, std::move(result))) {
+        qDebug() << "MergedProcessingPip: 帧" << frameId << "超出延迟预算，结果丢弃";
+    }
+    m_reorder.drain([this, &outSem](int readyId, ParallelResult& ready) {
+        emit processingComplete(readyId, ready.success);
+        emit sendOverSign(readyId);
+        pushOutFrame(std::move(ready.frame), outSem);
+    });
+    uint64_t late = m_reorder.lateFrames();
+    if (late > m_lateFrames) {
+        m_lateCounter->fetch_add(late - m_lateFrames, std::memory_order_relaxed);
     }
+    m_lateFrames = late;
 }
 
 // === 🔧 完整的帧处理函数 ===
-bool MergedProcessingPip::processFrameComplete(int frameId) {
+bool MergedProcessingPip::processFrameComplete(int frameId, const cv::Point& cropOrigin) {
     QElapsedTimer stepTimer;
 
     try {
         // === 🔧 初始化当前帧数据 ===
         currentFrame.clear();
         currentFrame.frameId = frameId;
+        currentFrame.cropOrigin = cropOrigin;
 
         // 从SharedPipelineData获取原始图像
         FrameData frameData;
@@ -122,12 +253,27 @@ bool MergedProcessingPip::processFrameComplete(int frameId) {
             return false;
         }
 
-        currentFrame.originalImage = frameData.originalImage.clone();
+        // 处理过程只读原图（归一化写入单独的缓冲区），共享引用即可，无需 clone
+        currentFrame.originalImage = frameData.originalImage;
         if (currentFrame.originalImage.empty()) {
             qDebug() << "原始图像为空，frameId:" << frameId;
             return false;
         }
 
+        // === 帧内任务图模式 ===
+        if (m_taskScheduler) {
+            double roiTime = 0, spotTime = 0, pupilTime = 0, gazeTime = 0;
+            if (!runFrameGraph(roiTime, spotTime, pupilTime, gazeTime)) {
+                return false;
+            }
+            saveResultsToSharedData();
+            recordStepTimes(roiTime, spotTime, pupilTime, gazeTime);
+            SharedPipelineData::setTime(frameId, 2, roiTime);
+            SharedPipelineData::setTime(frameId, 3, spotTime);
+            SharedPipelineData::setTime(frameId, 4, pupilTime);
+            return true;
+        }
+
         // === 步骤1: ROI提取 ===
         stepTimer.start();
         if (!performROIExtraction()) {
@@ -163,6 +309,7 @@ bool MergedProcessingPip::processFrameComplete(int frameId) {
 
         // === 🔧 保存结果到SharedPipelineData ===
         saveResultsToSharedData();
+        recordStepTimes(roiTime, spotTime, pupilTime, gazeTime);
 
         // 记录时间
         SharedPipelineData::setTime(frameId, 2, roiTime);
@@ -188,8 +335,26 @@ bool MergedProcessingPip::performROIExtraction() {
     try {
         // 优化4: 减少不必要的计算和内存分配
 
-        // 1. 最暗区域检测（已优化）
-        currentFrame.darkestCenter = rolExtraction->getDarkestArea(currentFrame.originalImage);
+        // 1. 最暗区域检测：跟踪上时只搜索预测位置周围的窗口；
+        //    暗点落在窗口边缘说明瞳孔可能已移出窗口，本帧改做全图搜索
+        const cv::Mat& image = currentFrame.originalImage;
+        cv::Rect window;
+        bool tracked = false;
+        if (m_roiTracker->searchWindow(currentFrame.frameId, currentFrame.cropOrigin, image.size(), window)) {
+            cv::Point local = findDarkestArea(image(window));
+            const int edge = 4;
+            if (local.x >= edge && local.y >= edge
+                && local.x < window.width - edge && local.y < window.height - edge) {
+                currentFrame.darkestCenter = local + window.tl();
+                tracked = true;
+            } else {
+                m_roiTracker->reportFailure(currentFrame.frameId);
+            }
+        }
+        if (!tracked) {
+            currentFrame.darkestCenter = findDarkestArea(image);
+        }
+        (tracked ? m_roiTrackedCounter : m_roiGlobalCounter)->fetch_add(1, std::memory_order_relaxed);
 
         // 2. ROI区域创建（避免重复计算）
         currentFrame.roiRect = rolExtraction->createIrisRol(currentFrame.originalImage, currentFrame.darkestCenter);
@@ -210,37 +375,225 @@ bool MergedProcessingPip::performROIExtraction() {
                             .arg(currentFrame.adjustedDarkPoint.x).arg(currentFrame.adjustedDarkPoint.y);
         }
 
-        return !currentFrame.roiImage.empty();
+        if (currentFrame.roiImage.empty()) {
+            m_roiTracker->reportFailure(currentFrame.frameId);
+            return false;
+        }
+        return true;
 
     } catch (const std::exception& e) {
         qCritical() << "ROI提取异常，frameId:" << currentFrame.frameId << "错误:" << e.what();
+        m_roiTracker->reportFailure(currentFrame.frameId);
         return false;
     }
 }
 
+cv::Point MergedProcessingPip::findDarkestArea(const cv::Mat& image) {
+    cv::Point center;
+    if (m_fastDarkLocator && darkLocator.locate(image, center)) {
+        return center;
+    }
+    return rolExtraction->getDarkestArea(image);
+}
+
+// === 🔧 帧内任务图 ===
+void MergedProcessingPip::setIntraFrameThreads(int threadCount) {
+    m_intraFrameThreads = std::max(1, threadCount);
+    m_taskScheduler.reset();
+    if (m_intraFrameThreads > 1) {
+        // 调用线程本身参与执行，额外线程数为 threadCount - 1
+        m_taskScheduler.reset(new TaskScheduler(m_intraFrameThreads - 1));
+        if (m_frameGraph.size() == 0) {
+            buildFrameGraph();
+        }
+    }
+
+    for (auto& worker : m_workers) {
+        worker->setIntraFrameThreads(m_intraFrameThreads);
+    }
+
+    qDebug() << "MergedProcessingPip: 帧内并行线程数" << m_intraFrameThreads;
+}
+
+void MergedProcessingPip::setRoiTracking(bool enabled, int refreshInterval) {
+    m_roiTracker->setRefreshInterval(refreshInterval);
+    m_roiTracker->setEnabled(enabled);
+    qDebug() << "MergedProcessingPip: ROI 跟踪" << (enabled ? "开启" : "关闭");
+}
+
+void MergedProcessingPip::setFastDarkLocator(bool enabled, int pupilDiameter) {
+    m_fastDarkLocator = enabled;
+    darkLocator.setWindowSize(pupilDiameter);
+    for (auto& worker : m_workers) {
+        worker->setFastDarkLocator(enabled, pupilDiameter);
+    }
+    qDebug() << "MergedProcessingPip: 快速最暗区域定位" << (enabled ? "开启" : "关闭")
+             << "窗口" << darkLocator.windowSize();
+}
+
+void MergedProcessingPip::setFastGlintExtraction(bool enabled) {
+    m_fastGlintExtraction = enabled;
+    for (auto& worker : m_workers) {
+        worker->setFastGlintExtraction(enabled);
+    }
+    qDebug() << "MergedProcessingPip: 游程光斑提取" << (enabled ? "开启" : "关闭");
+}
+
+void MergedProcessingPip::setGlintTracking(bool enabled, int refreshInterval) {
+    m_glintTracker->setRefreshInterval(refreshInterval);
+    m_glintTracker->setEnabled(enabled);
+    qDebug() << "MergedProcessingPip: 光斑跟踪" << (enabled ? "开启" : "关闭");
+}
+
+void MergedProcessingPip::buildFrameGraph() {
+    // ROI -> 光斑检测(220阈值/光斑修补/85阈值) -> { 光斑排列 | 瞳孔检测 } -> 注视点
+    // 85 瞳孔阈值作用于修补过光斑的模糊图，必须等光斑检测完成，不能与 220 阈值并行
+    TaskGraph::NodeId roi = m_frameGraph.addTask([this]() {
+        QElapsedTimer timer;
+        timer.start();
+        if (!performROIExtraction()) {
+            markGraphFailure("ROI提取失败");
+        }
+        m_graphRoiTime = timer.nsecsElapsed() / 1e6;
+    });
+
+    TaskGraph::NodeId detect = m_frameGraph.addTask([this]() {
+        if (m_graphFailed) return;
+        QElapsedTimer timer;
+        timer.start();
+        if (!detectLightSpots()) {
+            markGraphFailure("光斑检测失败");
+        }
+        m_graphDetectTime = timer.nsecsElapsed() / 1e6;
+    }, {roi});
+
+    TaskGraph::NodeId arrange = m_frameGraph.addTask([this]() {
+        if (m_graphFailed) return;
+        QElapsedTimer timer;
+        timer.start();
+        if (!arrangeLightSpots()) {
+            markGraphFailure("光斑检测失败");
+        }
+        m_graphArrangeTime = timer.nsecsElapsed() / 1e6;
+    }, {detect});
+
+    TaskGraph::NodeId pupil = m_frameGraph.addTask([this]() {
+        if (m_graphFailed) return;
+        QElapsedTimer timer;
+        timer.start();
+        if (!performPupilDetection()) {
+            markGraphFailure("瞳孔检测失败");
+        }
+        m_graphPupilTime = timer.nsecsElapsed() / 1e6;
+    }, {detect});
+
+    m_frameGraph.addTask([this]() {
+        if (m_graphFailed) return;
+        QElapsedTimer timer;
+        timer.start();
+        if (!calculateGazePoint()) {
+            markGraphFailure("注视点计算失败");
+        }
+        m_graphGazeTime = timer.nsecsElapsed() / 1e6;
+    }, {arrange, pupil});
+}
+
+bool MergedProcessingPip::runFrameGraph(double& roiTime, double& spotTime, double& pupilTime, double& gazeTime) {
+    m_graphFailed = false;
+    m_graphRoiTime = m_graphDetectTime = m_graphArrangeTime = m_graphPupilTime = m_graphGazeTime = 0;
+
+    m_frameGraph.run(*m_taskScheduler);
+
+    roiTime = m_graphRoiTime;
+    spotTime = m_graphDetectTime + m_graphArrangeTime;
+    pupilTime = m_graphPupilTime;
+    gazeTime = m_graphGazeTime;
+    return !m_graphFailed;
+}
+
+// === 🔧 性能指标 ===
+void MergedProcessingPip::bindMetrics() {
+    m_roiHist = &stepHistogram("roi");
+    m_spotHist = &stepHistogram("spot");
+    m_pupilHist = &stepHistogram("pupil");
+    m_gazeHist = &stepHistogram("gaze");
+    m_totalHist = &stepHistogram("total");
+    m_successCounter = &stageCounter("successFrames");
+    m_failureCounter = &stageCounter("failedFrames");
+    m_lateCounter = &stageCounter("lateFrames");
+    m_roiTrackedCounter = &stageCounter("roiTracked");
+    m_roiGlobalCounter = &stageCounter("roiGlobalSearch");
+    m_glintTrackedCounter = &stageCounter("glintTracked");
+    m_glintDetectedCounter = &stageCounter("glintDetected");
+
+    // worker 记录到同一组直方图（同名同指标对象）
+    for (auto& worker : m_workers) {
+        worker->setMetrics(&metrics());
+        worker->bindMetrics();
+    }
+}
+
+void MergedProcessingPip::recordStepTimes(double roiTime, double spotTime, double pupilTime, double gazeTime) {
+    m_roiHist->recordMs(roiTime);
+    m_spotHist->recordMs(spotTime);
+    m_pupilHist->recordMs(pupilTime);
+    m_gazeHist->recordMs(gazeTime);
+}
+
+void MergedProcessingPip::markGraphFailure(const char* step) {
+    // 光斑排列与瞳孔检测可能同时失败，只记录第一个
+    if (!m_graphFailed.exchange(true)) {
+        qWarning() << step << "，frameId:" << currentFrame.frameId;
+    }
+}
+
 // === 🔧 光斑检测 ===
 bool MergedProcessingPip::performSpotDetection() {
+    return detectLightSpots() && arrangeLightSpots();
+}
+
+// 预处理、光斑提取与修补，并生成瞳孔二值图
+bool MergedProcessingPip::detectLightSpots() {
     try {
-        // 1. 图像预处理
-        cv::Mat blur, outPutLightImage;
-        cv::normalize(currentFrame.roiImage, currentFrame.roiImage, 0, 255, cv::NORM_MINMAX);
-        cv::GaussianBlur(currentFrame.roiImage, blur, cv::Size(5, 5), 0);
-        cv::threshold(blur, outPutLightImage, 220, 255, cv::THRESH_BINARY);
+        // 1. 图像预处理（中间结果写入 currentFrame 的复用缓冲区，ROI 尺寸不变时不再分配）
+        // 归一化、高斯模糊和光斑二值化融合为一遍
+        cv::Mat& blur = currentFrame.blurImage;
+        cv::Mat& outPutLightImage = currentFrame.lightImage;
+        roiPreprocessor.process(currentFrame.roiImage, blur, outPutLightImage, 220);
 
         // 2. 光斑检测（使用调整后的暗点）
-        currentFrame.lightSpots = spotExtraction->lightExpection(outPutLightImage, currentFrame.adjustedDarkPoint);
+        // 跟踪上时只在四个预测窗口内测量（模糊图此时尚未修补光斑），跟丢后整幅提取
+        const cv::Point roiOrigin = currentFrame.cropOrigin + currentFrame.roiPoint;
+        currentFrame.glintsTracked = m_glintTracker->measure(currentFrame.frameId, blur, roiOrigin, currentFrame.trackedSpots);
+        (currentFrame.glintsTracked ? m_glintTrackedCounter : m_glintDetectedCounter)->fetch_add(1, std::memory_order_relaxed);
+        if (currentFrame.glintsTracked) {
+            currentFrame.lightSpots = currentFrame.trackedSpots;
+        } else if (m_fastGlintExtraction) {
+            currentFrame.lightSpots = glintExtractor.extract(outPutLightImage, currentFrame.adjustedDarkPoint);
+        } else {
+            currentFrame.lightSpots = spotExtraction->lightExpection(outPutLightImage, currentFrame.adjustedDarkPoint);
+        }
 
         // 3. 光斑智能处理
-        cv::Mat processedBlur = blur.clone();
+        // 模糊图之后只用于生成瞳孔二值图，直接在上面修补光斑，无需先拷贝一份
+        cv::Mat& processedBlur = blur;
         spotProcessor->processLightSpots(processedBlur, currentFrame.lightSpots,
                                          cv::Point2f(currentFrame.adjustedDarkPoint.x, currentFrame.adjustedDarkPoint.y), 30);
-        cv::Mat outPutPupilImage;
         //lijing
-        // cv::threshold(processedBlur, outPutPupilImage, 100, 255, cv::THRESH_BINARY);
+        // cv::threshold(processedBlur, currentFrame.processedImage, 100, 255, cv::THRESH_BINARY);
         //阳
-        cv::threshold(processedBlur, outPutPupilImage, 85, 255, cv::THRESH_BINARY);
+        cv::threshold(processedBlur, currentFrame.processedImage, 85, 255, cv::THRESH_BINARY);
+        return true;
 
-        currentFrame.processedImage = outPutPupilImage.clone();
+    } catch (const std::exception& e) {
+        qCritical() << "光斑检测异常，frameId:" << currentFrame.frameId << "错误:" << e.what();
+        return false;
+    }
+}
+
+// 光斑坐标还原与排列；只读写光斑字段，可与瞳孔检测并行
+bool MergedProcessingPip::arrangeLightSpots() {
+    try {
         // 4. 坐标调整（转换回全图坐标）
         for (auto& spot : currentFrame.lightSpots) {
             spot.center.x += (currentFrame.roiPoint.x );  // 减去边距
@@ -248,13 +601,24 @@ bool MergedProcessingPip::performSpotDetection() {
         }
 
 
-        // 5. 光斑排列
-        bool arrangeSuccess = spotExtraction->arrangeSpots(currentFrame.lightSpots, currentFrame.arrangedSpots);
+        // 5. 光斑排列：跟踪结果已按上一帧的排列顺序输出，不再重新排列
+        bool arrangeSuccess = true;
+        if (currentFrame.glintsTracked) {
+            currentFrame.arrangedSpots = currentFrame.trackedSpots;
+            for (auto& spot : currentFrame.arrangedSpots) {
+                spot.center.x += currentFrame.roiPoint.x;
+                spot.center.y += currentFrame.roiPoint.y;
+            }
+        } else {
+            arrangeSuccess = spotExtraction->arrangeSpots(currentFrame.lightSpots, currentFrame.arrangedSpots);
+        }
 
-        if (!arrangeSuccess) {
+        if (!arrangeSuccess || currentFrame.arrangedSpots.size() < 4) {
+            m_glintTracker->reportFailure(currentFrame.frameId);
             qDebug() << "光斑排列失败，frameId:" << currentFrame.frameId;
             return false;
         }
+        m_glintTracker->reportSuccess(currentFrame.frameId, currentFrame.arrangedSpots, currentFrame.cropOrigin);
 
         // 调试输出
         if (debugFlag && currentFrame.arrangedSpots.size() >= 4) {
@@ -285,7 +649,9 @@ bool MergedProcessingPip::performPupilDetection() {
             // 坐标调整（转换回全图坐标）
             currentFrame.pupilCircle.center.x += currentFrame.roiPoint.x;
             currentFrame.pupilCircle.center.y += currentFrame.roiPoint.y;
-
+            m_roiTracker->reportSuccess(currentFrame.frameId, currentFrame.pupilCircle.center,
+                                        std::max(currentFrame.pupilCircle.size.width, currentFrame.pupilCircle.size.height) / 2,
+                                        currentFrame.cropOrigin);
 
                 qDebug() << QString("Frame %1 瞳孔中心: (%2,%3), 尺寸: %4x%5 角度：%6")
                                 .arg(currentFrame.frameId)
@@ -296,7 +662,8 @@ bool MergedProcessingPip::performPupilDetection() {
         }
         else{
             qDebug() << "失败";
-
+            // 眨眼或遮挡，下一帧回到全图搜索
+            m_roiTracker->reportFailure(currentFrame.frameId);
         }
 
         return false;
@@ -460,11 +827,18 @@ void MergedProcessingPip::setMappingCoefficients(const std::vector<MappingCoeffi
         m_mappingCoefficients = coefficients;
         qDebug() << "MergedProcessingPip: 映射系数已更新，共" << coefficients.size() << "组";
     }
+
+    for (auto& worker : m_workers) {
+        worker->setMappingCoefficients(m_mappingCoefficients);
+    }
 }
 
 void MergedProcessingPip::setCombinedMappingCoefficients(const MappingCoefficients& coefficient)
 {
     combinedMappingCoefficients = coefficient;
+    for (auto& worker : m_workers) {
+        worker->setCombinedMappingCoefficients(coefficient);
+    }
     qDebug() << "MergedProcessingPip: 组合映射系数已更新";
 }
 
@@ -8,8 +8,18 @@
 #include "pupiletraction.h"
 #include "sharedpipelinedate.h"
 #include "smartspotprocessor.h"
+#include "framereorderbuffer.h"
+#include "taskscheduler.h"
+#include "roipreprocessor.h"
+#include "roitracker.h"
+#include "darkregionlocator.h"
+#include "glintextractor.h"
+#include "glinttracker.h"
+#include <QMutex>
+#include <QThreadPool>
 #include <deque>
 #include <chrono>
+#include <memory>
 
 class MergedProcessingPip : public QObject, public AbstractPipe {
     Q_OBJECT
@@ -24,15 +34,51 @@ public:
     std::vector<MappingCoefficients> getMappingCoefficients() const { return m_mappingCoefficients; }
     MappingCoefficients getCombinedMappingCoefficients() const { return combinedMappingCoefficients; }
 
+    // 帧级并行：workerCount > 1 时同时处理多帧，结果按 frameId 重排后再发出
+    // latencyBudgetMs 为等待慢帧的上限，超时的帧被放弃；需在管道启动前设置
+    void setParallelWorkers(int workerCount, double latencyBudgetMs = 50.0);
+    int parallelWorkers() const { return m_workerCount; }
+    uint64_t lateFrameCount() const { return m_lateFrames; }
+
+    // 帧内并行：threadCount > 1 时把单帧拆成任务图，ROI 之后光斑排列与瞳孔检测并行执行
+    // 目的是降低单帧延迟而非吞吐；需在管道启动前设置
+    void setIntraFrameThreads(int threadCount);
+    int intraFrameThreads() const { return m_intraFrameThreads; }
+
+    // ROI 帧间跟踪：稳定跟踪时只在上一帧瞳孔（按帧间速度外推）周围的小窗口内找最暗区域，
+    // 失败或眨眼后回到全图搜索，每 refreshInterval 帧也强制全图搜索一次
+    void setRoiTracking(bool enabled, int refreshInterval = 300);
+    bool roiTracking() const { return m_roiTracker->isEnabled(); }
+
+    // 最暗区域定位：enabled 时用由粗到细的积分图搜索（DarkRegionLocator），窗口边长取瞳孔直径；
+    // 默认关闭，使用 RolExtraction::getDarkestArea。两者判据不同（最小灰度和的方窗），
+    // 在录制数据上确认中心一致、并按实际瞳孔大小设好窗口后再开启
+    void setFastDarkLocator(bool enabled, int pupilDiameter = 80);
+    bool fastDarkLocator() const { return m_fastDarkLocator; }
+
+    // 光斑提取：enabled 时用游程连通域标记（GlintExtractor），默认关闭，使用 SpotExtraction::lightExpection。
+    // 两者的过滤条件和半径定义不同，在录制数据上确认结果一致之前不作为默认
+    void setFastGlintExtraction(bool enabled);
+    bool fastGlintExtraction() const { return m_fastGlintExtraction; }
+
+    // 光斑帧间跟踪：跟踪上时按上一帧位置预测四个光斑，只在小窗口内求灰度加权质心并按几何关系确认，
+    // 跟丢后回到整幅提取 + 排列，每 refreshInterval 帧也强制整幅提取一次
+    void setGlintTracking(bool enabled, int refreshInterval = 300);
+    bool glintTracking() const { return m_glintTracker->isEnabled(); }
+
 signals:
     void sendOverSign(int frameId);
     void processingComplete(int frameId, bool success);
 
 private:
     // === 🔧 核心处理函数 ===
-    bool processFrameComplete(int frameId);
+    bool processInputFrame(int frameId, const cv::Mat& src, const cv::Point& cropOrigin);
+    bool processFrameComplete(int frameId, const cv::Point& cropOrigin);
     bool performROIExtraction();
+    cv::Point findDarkestArea(const cv::Mat& image);
     bool performSpotDetection();
+    bool detectLightSpots();
+    bool arrangeLightSpots();
     bool performPupilDetection();
     bool calculateGazePoint();
 
@@ -47,11 +93,30 @@ private:
     void initializeDefaultMappingCoefficients();
     void saveResultsToSharedData();
 
+    // === 🔧 帧级并行 ===
+    struct ParallelResult {
+        bool success = false;
+        PipeFrame frame;
+    };
+    void pipeParallel(QSemaphore& inSem, QSemaphore& outSem);
+    MergedProcessingPip* takeWorker();
+    void completeParallelFrame(int frameId, ParallelResult&& result, QSemaphore& outSem);
+
+    // === 🔧 帧内任务图 ===
+    void buildFrameGraph();
+    bool runFrameGraph(double& roiTime, double& spotTime, double& pupilTime, double& gazeTime);
+    void markGraphFailure(const char* step);
+
     // === 🔧 处理组件 ===
     RolExtraction* rolExtraction;
     SpotExtraction* spotExtraction;
     PupilEtraction* pupilExtraction;
     SmartSpotProcessor* spotProcessor;
+    RoiPreprocessor roiPreprocessor;    // 归一化 + 模糊 + 光斑阈值的融合实现，缓冲区跨帧复用
+    DarkRegionLocator darkLocator;      // 由粗到细的最暗区域定位，缓冲区跨帧复用
+    bool m_fastDarkLocator = false;
+    GlintExtractor glintExtractor;      // 游程连通域的光斑提取，缓冲区跨帧复用
+    bool m_fastGlintExtraction = false;
 
     // === 🔧 简化的性能统计 ===
     struct SimplePerformanceStats {
@@ -88,33 +153,43 @@ private:
         cv::Mat roiImage;
         cv::Mat processedImage;
 
+        // 光斑检测中间缓冲区，跨帧复用
+        cv::Mat blurImage;
+        cv::Mat lightImage;
+
         // ROI相关数据
         cv::Point darkestCenter;
         cv::Point adjustedDarkPoint;
         cv::Point roiPoint;
         cv::Rect roiRect;
+        cv::Point cropOrigin;       // 原图左上角在采集画面中的坐标
 
 
         // 检测结果
         std::vector<Circle> lightSpots;
         std::vector<Circle> arrangedSpots;
+        std::vector<Circle> trackedSpots;   // 光斑跟踪的测量结果（ROI 坐标，已按排列顺序）
+        bool glintsTracked = false;
         Oval pupilCircle;
 
         // 计算结果
         cv::Point2f gazePoint;
         bool gazeValid = false;
 
+        // 只释放对原图的引用（让缓冲池回收），其余矩阵保留内存供下一帧复用
         void clear() {
             frameId = -1;
             originalImage.release();
-            roiImage.release();
             lightSpots.clear();
             arrangedSpots.clear();
+            trackedSpots.clear();
+            glintsTracked = false;
             gazeValid = false;
             darkestCenter = cv::Point(0, 0);
             adjustedDarkPoint = cv::Point(0, 0);
             roiPoint = cv::Point(0, 0);
             roiRect = cv::Rect(0, 0, 0, 0);
+            cropOrigin = cv::Point(0, 0);
             gazePoint = cv::Point2f(0, 0);
         }
     } currentFrame;
@@ -122,6 +197,50 @@ private:
     bool debugFlag = true;
     std::vector<MappingCoefficients> m_mappingCoefficients;
     MappingCoefficients combinedMappingCoefficients;
+    QString m_failedFrameDir = "failed_frames";
+
+    // ROI 跟踪状态，帧级并行时与所有 worker 共用
+    std::shared_ptr<RoiTracker> m_roiTracker;
+    // 光斑跟踪状态，同样与所有 worker 共用
+    std::shared_ptr<GlintTracker> m_glintTracker;
+
+    // 并行 worker：每个 worker 拥有独立的检测组件和帧数据
+    int m_workerCount = 1;
+    double m_latencyBudgetMs = 50.0;
+    std::vector<std::unique_ptr<MergedProcessingPip>> m_workers;
+    std::vector<MergedProcessingPip*> m_idleWorkers;
+    QMutex m_workerMutex;
+    QSemaphore m_workerSlots;
+    QMutex m_reorderMutex;
+    FrameReorderBuffer<ParallelResult> m_reorder;
+    std::atomic<uint64_t> m_lateFrames{0};
+
+    // 帧内任务图：图只构建一次，每帧复用；各节点只写自己负责的字段
+    int m_intraFrameThreads = 1;
+    std::unique_ptr<TaskScheduler> m_taskScheduler;
+    TaskGraph m_frameGraph;
+    std::atomic<bool> m_graphFailed{false};
+    double m_graphRoiTime = 0;
+    double m_graphDetectTime = 0;
+    double m_graphArrangeTime = 0;
+    double m_graphPupilTime = 0;
+    double m_graphGazeTime = 0;
+
+    // 性能指标（pipe() 开始时绑定，worker 共享同一组直方图）
+    void bindMetrics();
+    void recordStepTimes(double roiTime, double spotTime, double pupilTime, double gazeTime);
+    LatencyHistogram* m_roiHist = nullptr;
+    LatencyHistogram* m_spotHist = nullptr;
+    LatencyHistogram* m_pupilHist = nullptr;
+    LatencyHistogram* m_gazeHist = nullptr;
+    LatencyHistogram* m_totalHist = nullptr;
+    std::atomic<uint64_t>* m_successCounter = nullptr;
+    std::atomic<uint64_t>* m_failureCounter = nullptr;
+    std::atomic<uint64_t>* m_lateCounter = nullptr;
+    std::atomic<uint64_t>* m_roiTrackedCounter = nullptr;
+    std::atomic<uint64_t>* m_roiGlobalCounter = nullptr;
+    std::atomic<uint64_t>* m_glintTrackedCounter = nullptr;
+    std::atomic<uint64_t>* m_glintDetectedCounter = nullptr;
 };
 
 #endif // MERGEDPROCESSINGPIP_H
@@ -0,0 +1,240 @@
+#include "packetrecorder.h"
+#include <QDebug>
+#include <cstring>
+
+// ==================== 录制 ====================
+
+bool PacketRecorder::open(const QString& path, AVCodecID codecId, int width, int height,
+                          const uint8_t* extradata, int extradataSize)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "无法创建数据包录制文件:" << path;
+        return false;
+    }
+
+    char codecName[16];
+    memset(codecName, 0, sizeof(codecName));
+    strncpy(codecName, avcodec_get_name(codecId), sizeof(codecName) - 1);
+    int32_t size[2] = { width, height };
+    uint32_t extraSize = (extradata && extradataSize > 0) ? (uint32_t)extradataSize : 0;
+
+    bool ok = m_file.write(PacketArchive::MAGIC, sizeof(PacketArchive::MAGIC)) == sizeof(PacketArchive::MAGIC)
+              && m_file.write(reinterpret_cast<const char*>(&PacketArchive::VERSION), sizeof(uint32_t)) == sizeof(uint32_t)
+              && m_file.write(codecName, sizeof(codecName)) == sizeof(codecName)
+              && m_file.write(reinterpret_cast<const char*>(size), sizeof(size)) == sizeof(size)
+              && m_file.write(reinterpret_cast<const char*>(&extraSize), sizeof(extraSize)) == sizeof(extraSize)
+              && (extraSize == 0 || m_file.write(reinterpret_cast<const char*>(extradata), extraSize) == extraSize);
+    if (!ok) {
+        qWarning() << "写入数据包录制文件头失败:" << path;
+        m_file.close();
+        return false;
+    }
+
+    m_codecId = codecId;
+    m_width = width;
+    m_height = height;
+    m_written = 0;
+    m_dropped = 0;
+    m_stop = false;
+    m_writer = std::thread(&PacketRecorder::writerLoop, this);
+    m_open = true;
+
+    qDebug() << "开始录制数据包:" << path << avcodec_get_name(codecId) << width << "x" << height;
+    return true;
+}
+
+void PacketRecorder::close()
+{
+    if (!m_open) {
+        return;
+    }
+    m_open = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_writer.join();
+
+    m_file.close();
+    qDebug() << "数据包录制结束，写入" << packetsWritten() << "包，丢弃" << packetsDropped() << "包";
+}
+
+void PacketRecorder::write(const AVPacket* packet, int64_t captureTimeUs)
+{
+    if (!m_open) {
+        return;
+    }
+    AVPacket* ref = av_packet_alloc();
+    if (!ref || av_packet_ref(ref, packet) < 0) {
+        av_packet_free(&ref);
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    enqueue(ref, captureTimeUs);
+}
+
+void PacketRecorder::write(const uint8_t* data, size_t size, int64_t captureTimeUs)
+{
+    if (!m_open) {
+        return;
+    }
+    AVPacket* copy = av_packet_alloc();
+    if (!copy || av_new_packet(copy, (int)size) < 0) {
+        av_packet_free(&copy);
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    memcpy(copy->data, data, size);
+    copy->flags |= AV_PKT_FLAG_KEY;
+    enqueue(copy, captureTimeUs);
+}
+
+void PacketRecorder::enqueue(AVPacket* packet, int64_t captureTimeUs)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.size() < MAX_PENDING) {
+            m_pending.push_back({ packet, captureTimeUs });
+            packet = nullptr;
+        }
+    }
+    if (packet) {
+        av_packet_free(&packet);
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_cond.notify_one();
+}
+
+void PacketRecorder::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_cond.wait(lock, [this]() { return !m_pending.empty() || m_stop; });
+        if (m_pending.empty()) {
+            break;  // 停止且已写完
+        }
+
+        Pending item = m_pending.front();
+        m_pending.pop_front();
+        lock.unlock();
+
+        PacketArchive::PacketHeader header;
+        header.size = (uint32_t)item.packet->size;
+        header.flags = (uint32_t)item.packet->flags;
+        header.captureTimeUs = item.captureTimeUs;
+        header.pts = item.packet->pts;
+
+        bool ok = m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header)
+                  && m_file.write(reinterpret_cast<const char*>(item.packet->data), header.size) == header.size;
+        av_packet_free(&item.packet);
+        if (ok) {
+            m_written.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        lock.lock();
+    }
+    m_file.flush();
+}
+
+// ==================== 回放 ====================
+
+bool PacketReader::open(const QString& path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "无法打开数据包回放文件:" << path;
+        return false;
+    }
+
+    char magic[8];
+    uint32_t version = 0;
+    char codecName[17];
+    int32_t size[2] = { 0, 0 };
+    uint32_t extraSize = 0;
+    memset(codecName, 0, sizeof(codecName));
+
+    bool ok = m_file.read(magic, sizeof(magic)) == sizeof(magic)
+              && memcmp(magic, PacketArchive::MAGIC, sizeof(magic)) == 0
+              && m_file.read(reinterpret_cast<char*>(&version), sizeof(version)) == sizeof(version)
+              && version == PacketArchive::VERSION
+              && m_file.read(codecName, 16) == 16
+              && m_file.read(reinterpret_cast<char*>(size), sizeof(size)) == sizeof(size)
+              && m_file.read(reinterpret_cast<char*>(&extraSize), sizeof(extraSize)) == sizeof(extraSize);
+    if (!ok) {
+        qWarning() << "不是数据包录制文件或版本不支持:" << path;
+        m_file.close();
+        return false;
+    }
+
+    const AVCodecDescriptor* descriptor = avcodec_descriptor_get_by_name(codecName);
+    if (!descriptor) {
+        qWarning() << "回放文件的编解码器未知:" << codecName;
+        m_file.close();
+        return false;
+    }
+
+    m_codecpar = avcodec_parameters_alloc();
+    m_codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    m_codecpar->codec_id = descriptor->id;
+    m_codecpar->width = size[0];
+    m_codecpar->height = size[1];
+    if (extraSize > 0) {
+        m_codecpar->extradata = (uint8_t*)av_mallocz(extraSize + AV_INPUT_BUFFER_PADDING_SIZE);
+        m_codecpar->extradata_size = (int)extraSize;
+        if (m_file.read(reinterpret_cast<char*>(m_codecpar->extradata), extraSize) != extraSize) {
+            qWarning() << "回放文件头不完整:" << path;
+            close();
+            return false;
+        }
+    }
+
+    m_firstPacketOffset = m_file.pos();
+    qDebug() << "打开数据包回放:" << path << codecName << size[0] << "x" << size[1];
+    return true;
+}
+
+void PacketReader::close()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    avcodec_parameters_free(&m_codecpar);
+    m_firstPacketOffset = 0;
+}
+
+bool PacketReader::next(AVPacket* packet, int64_t& captureTimeUs)
+{
+    PacketArchive::PacketHeader header;
+    if (m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header)) {
+        return false;
+    }
+    if (av_new_packet(packet, (int)header.size) < 0) {
+        return false;
+    }
+    if (m_file.read(reinterpret_cast<char*>(packet->data), header.size) != header.size) {
+        av_packet_unref(packet);
+        return false;   // 录制中断留下的不完整数据包
+    }
+
+    packet->flags = (int)header.flags;
+    packet->pts = header.pts;
+    packet->dts = header.pts;
+    packet->stream_index = 0;
+    captureTimeUs = header.captureTimeUs;
+    return true;
+}
+
+bool PacketReader::rewind()
+{
+    return m_file.isOpen() && m_file.seek(m_firstPacketOffset);
+}
@@ -0,0 +1,128 @@
+#ifndef PACKETRECORDER_H
+#define PACKETRECORDER_H
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * 原始数据包录制 / 回放
+ *
+ * 直播采集时把解码前的数据包（MJPEG 每包一帧）连同采集时间戳原样追加到文件，
+ * 不解码也不重新编码；回放时按原顺序读出同样的字节送入解码器，可以逐位复现一次采集。
+ *
+ * 文件格式（小端）：
+ *   文件头  magic "NYSPKT01" | uint32 版本 | char[16] 编解码器名 | int32 宽 | int32 高
+ *           | uint32 extradata 长度 | extradata
+ *   数据包  uint32 长度 | uint32 标志(AV_PKT_FLAG_*) | int64 采集时间戳(µs) | int64 pts | 负载
+ * 只追加写入，进程异常退出时末尾不完整的数据包在回放时被忽略。
+ */
+namespace PacketArchive {
+    static const char MAGIC[8] = { 'N', 'Y', 'S', 'P', 'K', 'T', '0', '1' };
+    static const uint32_t VERSION = 1;
+
+    struct PacketHeader {
+        uint32_t size;
+        uint32_t flags;
+        int64_t captureTimeUs;
+        int64_t pts;
+    };
+}
+
+/**
+ * 录制端：write() 只增加数据包引用计数并入队，磁盘写入在独立线程完成，采集线程不被 I/O 阻塞。
+ * 写入跟不上时丢弃新包并计数。
+ */
+class PacketRecorder {
+public:
+    PacketRecorder() {}
+    ~PacketRecorder() { close(); }
+
+    PacketRecorder(const PacketRecorder&) = delete;
+    PacketRecorder& operator=(const PacketRecorder&) = delete;
+
+    bool open(const QString& path, AVCodecID codecId, int width, int height,
+              const uint8_t* extradata = nullptr, int extradataSize = 0);
+    void close();
+    bool isOpen() const { return m_open; }
+
+    // 采集线程调用；FFmpeg 数据包按引用入队，裸缓冲区（V4L2）拷贝一次
+    void write(const AVPacket* packet, int64_t captureTimeUs);
+    void write(const uint8_t* data, size_t size, int64_t captureTimeUs);
+
+    // 与文件头的参数一致才能继续追加
+    bool matches(AVCodecID codecId, int width, int height) const {
+        return m_codecId == codecId && m_width == width && m_height == height;
+    }
+
+    uint64_t packetsWritten() const { return m_written.load(std::memory_order_relaxed); }
+    uint64_t packetsDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Pending {
+        AVPacket* packet;
+        int64_t captureTimeUs;
+    };
+
+    void enqueue(AVPacket* packet, int64_t captureTimeUs);
+    void writerLoop();
+
+    static const size_t MAX_PENDING = 256;   // MJPEG 720p 约 25MB
+
+    QFile m_file;
+    std::atomic<bool> m_open{false};
+    AVCodecID m_codecId = AV_CODEC_ID_NONE;
+    int m_width = 0;
+    int m_height = 0;
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Pending> m_pending;
+    bool m_stop = false;
+
+    std::atomic<uint64_t> m_written{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+/**
+ * 回放端：顺序读出录制的数据包，codecParameters() 用于创建解码器
+ */
+class PacketReader {
+public:
+    PacketReader() {}
+    ~PacketReader() { close(); }
+
+    PacketReader(const PacketReader&) = delete;
+    PacketReader& operator=(const PacketReader&) = delete;
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    // 读下一个数据包到 packet（负载直接读进数据包缓冲区），文件结束或末尾不完整时返回 false
+    bool next(AVPacket* packet, int64_t& captureTimeUs);
+
+    // 回到第一个数据包
+    bool rewind();
+
+    // 解码器参数，由本对象持有
+    const AVCodecParameters* codecParameters() const { return m_codecpar; }
+
+private:
+    QFile m_file;
+    qint64 m_firstPacketOffset = 0;
+    AVCodecParameters* m_codecpar = nullptr;
+};
+
+#endif // PACKETRECORDER_H
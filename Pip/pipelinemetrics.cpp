@@ -0,0 +1,102 @@
+#include "pipelinemetrics.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+
+PipelineMetrics& PipelineMetrics::global()
+{
+    static PipelineMetrics metrics;
+    return metrics;
+}
+
+LatencyHistogram& PipelineMetrics::histogram(const std::string& stage, const std::string& step)
+{
+    QMutexLocker locker(&m_mutex);
+    std::unique_ptr<LatencyHistogram>& slot = m_histograms[makeKey(stage, step)];
+    if (!slot) {
+        slot.reset(new LatencyHistogram());
+    }
+    return *slot;
+}
+
+std::atomic<uint64_t>& PipelineMetrics::counter(const std::string& stage, const std::string& name)
+{
+    QMutexLocker locker(&m_mutex);
+    std::unique_ptr<std::atomic<uint64_t>>& slot = m_counters[makeKey(stage, name)];
+    if (!slot) {
+        slot.reset(new std::atomic<uint64_t>(0));
+    }
+    return *slot;
+}
+
+LatencyHistogram::Snapshot PipelineMetrics::snapshot(const std::string& stage, const std::string& step) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_histograms.find(makeKey(stage, step));
+    if (it == m_histograms.end()) {
+        return LatencyHistogram::Snapshot();
+    }
+    return it->second->snapshot();
+}
+
+uint64_t PipelineMetrics::counterValue(const std::string& stage, const std::string& name) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_counters.find(makeKey(stage, name));
+    if (it == m_counters.end()) {
+        return 0;
+    }
+    return it->second->load(std::memory_order_relaxed);
+}
+
+QString PipelineMetrics::report() const
+{
+    QMutexLocker locker(&m_mutex);
+    QString text;
+    QTextStream out(&text);
+
+    out << "# pipeline metrics " << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz") << "\n";
+    out << "# histogram, count, mean_ms, p50_ms, p99_ms, p99.9_ms, max_ms\n";
+    for (const auto& item : m_histograms) {
+        LatencyHistogram::Snapshot snap = item.second->snapshot();
+        out << QString::fromStdString(item.first) << ", " << snap.count
+            << ", " << QString::number(snap.meanMs, 'f', 3)
+            << ", " << QString::number(snap.p50Ms, 'f', 3)
+            << ", " << QString::number(snap.p99Ms, 'f', 3)
+            << ", " << QString::number(snap.p999Ms, 'f', 3)
+            << ", " << QString::number(snap.maxMs, 'f', 3) << "\n";
+    }
+
+    out << "# counter, value\n";
+    for (const auto& item : m_counters) {
+        out << QString::fromStdString(item.first) << ", "
+            << item.second->load(std::memory_order_relaxed) << "\n";
+    }
+    out.flush();
+    return text;
+}
+
+bool PipelineMetrics::dump(const QString& path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        qWarning() << "无法写入性能指标文件:" << path;
+        return false;
+    }
+    QTextStream out(&file);
+    out << report();
+    qDebug() << "性能指标已保存:" << path;
+    return true;
+}
+
+void PipelineMetrics::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto& item : m_histograms) {
+        item.second->reset();
+    }
+    for (auto& item : m_counters) {
+        item.second->store(0, std::memory_order_relaxed);
+    }
+}
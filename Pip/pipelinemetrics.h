@@ -0,0 +1,52 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include "latencyhistogram.h"
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * 管道性能指标
+ *
+ * 按 “级名/子步骤名” 组织延迟直方图和帧计数器。
+ * 注册（histogram()/counter()）需要加锁，应在处理循环外完成并缓存返回的引用；
+ * 循环内的记录全部是无锁原子操作。返回的引用在本对象生命周期内一直有效。
+ */
+class PipelineMetrics {
+public:
+    PipelineMetrics() {}
+
+    PipelineMetrics(const PipelineMetrics&) = delete;
+    PipelineMetrics& operator=(const PipelineMetrics&) = delete;
+
+    // 默认的全局指标，未单独设置时各级都记录到这里
+    static PipelineMetrics& global();
+
+    LatencyHistogram& histogram(const std::string& stage, const std::string& step);
+    std::atomic<uint64_t>& counter(const std::string& stage, const std::string& name);
+
+    // 运行时查询，不存在时返回空快照/0
+    LatencyHistogram::Snapshot snapshot(const std::string& stage, const std::string& step) const;
+    uint64_t counterValue(const std::string& stage, const std::string& name) const;
+
+    // 文本报表：每行一个直方图（count/mean/p50/p99/p99.9/max，单位 ms）和计数器
+    QString report() const;
+    bool dump(const QString& path) const;
+
+    void reset();
+
+private:
+    static std::string makeKey(const std::string& stage, const std::string& name) {
+        return stage + "/" + name;
+    }
+
+    mutable QMutex m_mutex;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> m_histograms;
+    std::map<std::string, std::unique_ptr<std::atomic<uint64_t>>> m_counters;
+};
+
+#endif // PIPELINEMETRICS_H
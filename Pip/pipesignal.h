@@ -0,0 +1,43 @@
+#ifndef PIPESIGNAL_H
+#define PIPESIGNAL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * 管道状态通知
+ *
+ * 暂停/恢复/退出/关闭等状态由原子标志表示，状态改变后调用 notifyAll()，
+ * 等待方用谓词检查标志，替代 “sleep 一段时间再轮询” 的写法。
+ * notifyAll() 内部先加锁再通知，保证谓词检查与通知之间不会丢失唤醒。
+ */
+class PipeSignal {
+public:
+    void notifyAll() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_cond.notify_all();
+    }
+
+    // 阻塞直到谓词成立
+    template <typename Predicate>
+    void wait(Predicate pred) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, pred);
+    }
+
+    // 最多等待 timeout，返回谓词是否成立（false 表示超时）
+    template <typename Predicate, typename Rep, typename Period>
+    bool waitFor(Predicate pred, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, timeout, pred);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
+
+#endif // PIPESIGNAL_H
@@ -1,22 +1,12 @@
 #include "pipline.h"
 
-QSemaphore pipline::m_processInSem[6];
-QSemaphore pipline::m_processOutSem[6];
-QSemaphore pipline::m_dummySem;
-AbstractPipe * pipline::m_pipe0;
-AbstractPipe * pipline::m_pipe1;
-AbstractPipe * pipline::m_pipe2;
-AbstractPipe * pipline::m_pipe3;
-thread * pipline::m_t0;
-thread * pipline::m_t1;
-thread * pipline::m_t2;
-thread * pipline::m_t3;
-vector<AbstractPipe *>  pipline::m_pipe_processes;
-vector<thread *> pipline::m_threads_processes;
-Mat pipline::m_Images[6];
-FrameImage pipline::m_FrameImages[6];
-
 pipline::pipline()
 {
 
 }
+
+pipline::~pipline()
+{
+    // 各级对象由调用方持有，这里只负责停止并回收本管道启动的线程
+    deletePipeLine();
+}
@@ -5,7 +5,9 @@
 #include <vector>
 #include <map>
 #include <thread>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <opencv2/core/core.hpp>
 #include <opencv2/opencv.hpp>
 #include <QSemaphore>
@@ -13,6 +15,9 @@
 #include<qlabel.h>
 #include <mutex>
 #include "class.h"
+#include "framering.h"
+#include "pipelinemetrics.h"
+#include "pipesignal.h"
 using namespace std;
 using namespace cv;
 
@@ -34,49 +39,124 @@ public:
 
     virtual void pipe(QSemaphore &inSem, QSemaphore &outSem) = 0;
 
-    void setInImage(void* pInImage) {
-        m_pInImage = pInImage;
+    void setInRing(FrameRing* pInRing) {
+        m_inRing = pInRing;
     }
 
-    void setOutImage(void* pOutImage) {
-        m_pOutImage = pOutImage;
+    void setOutRing(FrameRing* pOutRing) {
+        m_outRing = pOutRing;
     }
 
-    bool exit() {
+    bool exit() const {
         return m_exit;
     }
 
+    // 置位后立即唤醒本级：阻塞在输入信号量上的 popInFrame 和等待状态变化的线程。
+    // 先发布标志再读 m_waitingSem，与 popInFrame 的“先登记再检查标志”配对（均为 seq_cst）：
+    // 要么 popInFrame 看到退出标志不再等待，要么这里看到登记的信号量并唤醒它
     void setExit(bool flag) {
-        m_exit = flag;
+        m_exit.store(flag);
+        m_stateSignal.notifyAll();
+        if (flag) {
+            QSemaphore* waiting = m_waitingSem.load();
+            if (waiting) {
+                waiting->release();
+            }
+        }
     }
-    bool isPaused(){
+    bool isPaused() const {
         return m_paused;
     }
     void setPaused(bool flag){
         m_paused = flag;
+        m_stateSignal.notifyAll();
+    }
+
+    // 性能指标：未设置时记录到 PipelineMetrics::global()，需在管道启动前设置
+    void setMetrics(PipelineMetrics* metrics) {
+        m_metrics = metrics;
+    }
+    PipelineMetrics& metrics() const {
+        return m_metrics ? *m_metrics : PipelineMetrics::global();
     }
 
 protected:
+    // 本级子步骤直方图/计数器，应在处理循环外取一次并缓存引用
+    LatencyHistogram& stepHistogram(const char* step) {
+        return metrics().histogram(m_pipeName, step);
+    }
+    std::atomic<uint64_t>& stageCounter(const char* name) {
+        return metrics().counter(m_pipeName, name);
+    }
+
+    // 从上一级取帧：inSem 的计数与输入队列中的帧数对应。
+    // 先登记等待的信号量再检查退出标志，setExit 与循环条件检查之间的竞争不会漏掉唤醒；
+    // 唤醒后再检查一次，退出时不取帧。多出的 release 在下次启动时随队列重置一并清掉
+    bool popInFrame(QSemaphore &inSem, PipeFrame &frame) {
+        m_waitingSem.store(&inSem);
+        if (exit()) {
+            return false;
+        }
+        inSem.acquire();
+        if (exit()) {
+            return false;
+        }
+        return m_inRing && m_inRing->tryPop(frame);
+    }
+
+    // 向下一级送帧：队列满时丢弃本帧，上游永不阻塞；末级没有输出队列
+    bool pushOutFrame(PipeFrame &&frame, QSemaphore &outSem) {
+        if (!m_outRing || !m_outRing->tryPush(std::move(frame))) {
+            return false;
+        }
+        outSem.release();
+        return true;
+    }
+
+    // 向下一级送帧，队列满时等待下游腾出空位而不丢帧（离线回放由下游处理速度决定节奏）；
+    // 退出时返回 false
+    bool pushOutFrameWait(PipeFrame &&frame, QSemaphore &outSem) {
+        if (!m_outRing || !m_outRing->pushWait(std::move(frame), [this]() { return exit(); })) {
+            return false;
+        }
+        outSem.release();
+        return true;
+    }
 
     string m_pipeName;
     PIPE_TYPE_E m_pipeType;
-    bool m_exit;
-    void* m_pInImage;
-    void* m_pOutImage;
-    bool m_paused = false;  //暂停标志位
+    std::atomic<bool> m_exit;
+    FrameRing* m_inRing = nullptr;
+    FrameRing* m_outRing = nullptr;
+    PipelineMetrics* m_metrics = nullptr;
+    std::atomic<bool> m_paused{false};  //暂停标志位
+    PipeSignal m_stateSignal;            // 暂停/退出等状态变化通知
+    std::atomic<QSemaphore*> m_waitingSem{nullptr};  // popInFrame 正在等待的信号量
 };
 
 
+/**
+ * 处理管道实例
+ *
+ * 每个实例拥有自己的级、级间队列、信号量、线程和性能指标，
+ * 同一进程中可以同时运行多条互不干扰的管道（例如两路摄像头/两段录像）。
+ * 实例不拥有各级对象，但析构时会先停止并回收自己启动的全部线程。
+ */
 class pipline
 {
 public:
     pipline();
-    static void add_process_modles(AbstractPipe * pipe)
+    ~pipline();
+
+    pipline(const pipline&) = delete;
+    pipline& operator=(const pipline&) = delete;
+
+    void add_process_modles(AbstractPipe * pipe)
     {
         m_pipe_processes.push_back(pipe);
     }
 
-    static void remove_process_modles(AbstractPipe * pipe)
+    void remove_process_modles(AbstractPipe * pipe)
     {
         auto it = find(m_pipe_processes.begin(), m_pipe_processes.end(), pipe);
         if (it != (m_pipe_processes.end())) {
@@ -87,36 +167,44 @@ public:
         }
     }
 
-    static void creat_capturepip(AbstractPipe * pipe, bool startPaused )
+    void creat_capturepip(AbstractPipe * pipe, bool startPaused )
     {
 
         m_pipe0 = pipe;
-        m_processInSem[0].tryAcquire();
+        m_pipe0->setMetrics(&m_metrics);
+        // 采集线程尚未启动，此时可以安全地清空第0级队列并让信号量与之对齐
+        resetRing(0);
         m_pipe0->setExit(false);
         m_pipe0->setPaused(startPaused);
-        m_pipe0->setOutImage(&m_FrameImages[0]);
+        m_pipe0->setOutRing(&m_frameRings[0]);
         m_t0 = new thread(&AbstractPipe::pipe, m_pipe0, ref(m_dummySem), ref(m_processInSem[0]));
     }
 
 
-    static void createPipeLine()
+    void createPipeLine()
     {
 
         //初始化信号量
-        m_dummySem.tryAcquire();
+        m_dummySem.tryAcquire(m_dummySem.available());
 
+        // 第0级由采集线程写入，可能已在运行，只重置处理级之间的队列
+        for (size_t i = 1; i < 6; ++i) {
+            resetRing(i);
+        }
         for (size_t i = 0; i < 5; ++i) {
-            m_processInSem[i].tryAcquire();
-            m_processOutSem[i].tryAcquire();
+            m_processOutSem[i].tryAcquire(m_processOutSem[i].available());
         }
 
 
         // 创建处理管道线程
         for (size_t i = 0; i < m_pipe_processes.size(); ++i) {
             AbstractPipe* pipe = m_pipe_processes[i];
+            bool isLast = (i + 1 == m_pipe_processes.size());
             pipe->setExit(false);
-            pipe->setInImage(&m_FrameImages[i]);
-            pipe->setOutImage(&m_FrameImages[i+1]);
+            pipe->setMetrics(&m_metrics);
+            pipe->setInRing(&m_frameRings[i]);
+            // 末级没有消费者，不挂输出队列
+            pipe->setOutRing(isLast ? nullptr : &m_frameRings[i+1]);
 
             m_threads_processes.push_back(
                 new thread(&AbstractPipe::pipe, pipe,
@@ -127,7 +215,7 @@ public:
     }
 
 
-    static void deleteALLPip()
+    void deleteALLPip()
     {
 
         for (size_t i = 0; i < m_pipe_processes.size(); ++i) {
@@ -166,7 +254,7 @@ public:
 
         }
     }
-    static void updateProcessModule(AbstractPipe* pipe, bool add) {
+    void updateProcessModule(AbstractPipe* pipe, bool add) {
         if (!pipe) {
             qCritical() << "错误：传入的处理模块为空";
             return;
@@ -220,12 +308,13 @@ public:
 
         qDebug() << "完成" << (add ? "添加" : "移除") << "处理模块";
     }
-    static void reconfigurePipeLine() {
-        // 更新处理模块的输入输出图像
+    void reconfigurePipeLine() {
+        // 更新处理模块的输入输出队列
         for (size_t i = 0; i < m_pipe_processes.size(); ++i) {
             AbstractPipe* pipe = m_pipe_processes[i];
-            pipe->setInImage(&m_Images[i]);
-            pipe->setOutImage(&m_Images[i+1]);
+            bool isLast = (i + 1 == m_pipe_processes.size());
+            pipe->setInRing(&m_frameRings[i]);
+            pipe->setOutRing(isLast ? nullptr : &m_frameRings[i+1]);
         }
 
         // 释放末端信号量，确保管道能继续流动
@@ -236,7 +325,7 @@ public:
 
 
     // 移除所有处理模块但保持管道结构
-    static void removeAllProcessModules() {
+    void removeAllProcessModules() {
         // 暂停所有管道
         pausePipeLine();
 
@@ -251,14 +340,13 @@ public:
         std::cout << "所有处理模块已移除" << std::endl;
     }
 
-    static void safeDeletePipeline() {
+    void safeDeletePipeline() {
         try {
             // 先暂停所有线程
             for (size_t i = 0; i < m_pipe_processes.size(); ++i) {
                 if(m_pipe_processes[i]){
+                    // setExit 会立即唤醒阻塞中的线程，无需等待其响应暂停
                     m_pipe_processes[i]->setPaused(true);
-                    // 给线程一点时间来响应暂停
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
                     m_pipe_processes[i]->setExit(true);
                 }
             }
@@ -299,7 +387,7 @@ public:
             std::cerr << "关闭管道线程时发生未知异常" << std::endl;
         }
     }
-    static void deletePipeLine()
+    void deletePipeLine()
     {
 
         // 通知所有线程退出
@@ -365,7 +453,7 @@ public:
         }
     }
     //暂停处理
-    static void pausePipeLine(){
+    void pausePipeLine(){
         for(auto pipe : m_pipe_processes){
             if(pipe){
                 pipe->setPaused(true);
@@ -378,7 +466,7 @@ public:
 
 
     //恢复处理
-    static void resumePipeLine(){
+    void resumePipeLine(){
         for(auto pipe : m_pipe_processes)
             if(pipe){
                 pipe->setPaused(false);
@@ -388,22 +476,57 @@ public:
         if(m_pipe2) m_pipe2->setPaused(false);
     }
 
+    // 设置级间队列深度，在下次创建管道时生效
+    void setRingDepth(size_t depth) {
+        m_ringDepth = depth < 2 ? 2 : depth;
+    }
+
+    size_t ringDepth() {
+        return m_ringDepth;
+    }
+
+    // 各级队列因满而丢弃的帧数
+    uint64_t droppedFrames(size_t stage) {
+        return stage < 6 ? m_frameRings[stage].droppedCount() : 0;
+    }
+
+    // 导出性能指标（各级直方图、计数器以及队列丢帧数）
+    bool dumpMetrics(const QString& path) {
+        for (size_t i = 0; i < 6; ++i) {
+            m_metrics.counter("FrameRing" + std::to_string(i), "dropped")
+                .store(m_frameRings[i].droppedCount(), std::memory_order_relaxed);
+        }
+        return m_metrics.dump(path);
+    }
+
+    // 本管道的性能指标，创建管道时各级的指标都指向这里
+    PipelineMetrics& metrics() {
+        return m_metrics;
+    }
+
 private:
-    static QSemaphore m_processInSem[6];
-    static QSemaphore m_processOutSem[6];
-    static QSemaphore m_dummySem;
-    static vector<thread *> m_threads_processes;
-    static vector<AbstractPipe *>  m_pipe_processes;
-    static AbstractPipe * m_pipe0;
-    static AbstractPipe * m_pipe1;
-    static AbstractPipe * m_pipe2;
-    static AbstractPipe * m_pipe3;
-    static thread * m_t0;
-    static thread * m_t1;
-    static thread * m_t2;
-    static thread * m_t3;
-    static Mat m_Images[6];
-    static FrameImage m_FrameImages[6];
+    // 只能在该队列两端线程都未运行时调用
+    void resetRing(size_t i) {
+        m_frameRings[i].reset(m_ringDepth);
+        m_processInSem[i].tryAcquire(m_processInSem[i].available());
+    }
+
+    QSemaphore m_processInSem[6];
+    QSemaphore m_processOutSem[6];
+    QSemaphore m_dummySem;
+    vector<thread *> m_threads_processes;
+    vector<AbstractPipe *>  m_pipe_processes;
+    AbstractPipe * m_pipe0 = nullptr;
+    AbstractPipe * m_pipe1 = nullptr;
+    AbstractPipe * m_pipe2 = nullptr;
+    AbstractPipe * m_pipe3 = nullptr;
+    thread * m_t0 = nullptr;
+    thread * m_t1 = nullptr;
+    thread * m_t2 = nullptr;
+    thread * m_t3 = nullptr;
+    FrameRing m_frameRings[6];
+    size_t m_ringDepth = 4;
+    PipelineMetrics m_metrics;
 };
 
 #endif // PIPLINE_H
@@ -12,25 +12,37 @@ public:
     pupilExtractionPip() : QObject(), AbstractPipe("PupilPipe", PIPE_PROCESS_E) {};
 
     void pipe(QSemaphore& inSem, QSemaphore& outSem) {
-        FrameImage* pInFrame = (FrameImage*)m_pInImage;
-        FrameImage* pOutFrame = (FrameImage*)m_pOutImage;
+        // 子步骤直方图在循环外注册，循环内只做无锁记录
+        LatencyHistogram& pupilDetectionHist = stepHistogram("pupilDetection");
+        LatencyHistogram& frameDataHist = stepHistogram("getFrameData");
+        LatencyHistogram& coordinateHist = stepHistogram("coordinateAdjust");
+        LatencyHistogram& dataSaveHist = stepHistogram("dataSave");
+        LatencyHistogram& transferHist = stepHistogram("imageTransfer");
+        LatencyHistogram& completionHist = stepHistogram("completionCheck");
+        LatencyHistogram& recordingHist = stepHistogram("recording");
+        LatencyHistogram& totalHist = stepHistogram("total");
+        std::atomic<uint64_t>& frameCounter = stageCounter("frames");
+        std::atomic<uint64_t>& emptyCounter = stageCounter("emptyFrames");
+        std::atomic<uint64_t>& pupilFailCounter = stageCounter("pupilFailures");
+        std::atomic<uint64_t>& incompleteCounter = stageCounter("incompleteFrames");
 
         while (!exit()) {
-            inSem.acquire();
+            PipeFrame inFrame;
+            if (!popInFrame(inSem, inFrame)) {
+                continue;
+            }
             QElapsedTimer totalTimer, stepTimer;
             totalTimer.start();
-            int frameId;
-            if (pInFrame && !pInFrame->image.empty()) {
-                // ========== 1. 图像克隆 ==========
-                stepTimer.start();
-                cv::Mat src = pInFrame->image.clone();
-                frameId = pInFrame->frameId;
-                double cloneTime = stepTimer.nsecsElapsed() / 1e6;
+            int frameId = inFrame.frameId;
+            if (!inFrame.image.empty()) {
+                // 上一级每帧新生成二值图，出队后归本级独占，上游不会再写入，无需 clone；
+                // 检测后原样（引用计数）交给下一级
+                cv::Mat& src = inFrame.image;
 
                 // ========== 2. 瞳孔检测 ==========
-                stepTimer.restart();
+                stepTimer.start();
                 Oval pupilCircle;
-                bool resultFlag = pupilExtraction.pupilDetection(src, pupilCircle, pInFrame->frameId);
+                bool resultFlag = pupilExtraction.pupilDetection(src, pupilCircle, frameId);
 
                 double pupilDetectionTime = stepTimer.nsecsElapsed() / 1e6;
 
@@ -41,7 +53,8 @@ public:
                 double frameDataTime = 0.0;
                 double dataSaveTime = 0.0;
 
-                if (SharedPipelineData::getFrameData(frameId, frameData)) {
+                bool hasFrameData = SharedPipelineData::getFrameData(frameId, frameData);
+                if (hasFrameData) {
                     frameDataTime = stepTimer.nsecsElapsed() / 1e6;
 
                     stepTimer.restart();
@@ -56,8 +69,15 @@ public:
                 }
                 // ========== 8. 图像传递 ==========
                 stepTimer.restart();
-                pOutFrame->image = src;
-                pOutFrame->frameId = frameId;
+                PipeFrame outFrame;
+                outFrame.image = std::move(src);
+                outFrame.frameId = frameId;
+                outFrame.captureTimeUs = inFrame.captureTimeUs;
+                outFrame.sequence = inFrame.sequence;
+                outFrame.intervalUs = inFrame.intervalUs;
+                outFrame.droppedBefore = inFrame.droppedBefore;
+                outFrame.cropOrigin = inFrame.cropOrigin;
+                pushOutFrame(std::move(outFrame), outSem);
                 double imageTransferTime = stepTimer.nsecsElapsed() / 1e6;
 
                 // ========== 9. 完成检查 ==========
@@ -77,12 +97,27 @@ public:
                 SharedPipelineData::setTime(frameId, 4, totalMs);
                 double recordingTime = stepTimer.nsecsElapsed() / 1e6;
 
-                // ========== 性能报告输出 ==========
-                static int frameCount = 0;
-                frameCount++;
-
+                // ========== 性能指标 ==========
+                pupilDetectionHist.recordMs(pupilDetectionTime);
+                if (hasFrameData) {
+                    frameDataHist.recordMs(frameDataTime);
+                    coordinateHist.recordMs(coordinateAdjustTime);
+                    dataSaveHist.recordMs(dataSaveTime);
+                }
+                transferHist.recordMs(imageTransferTime);
+                completionHist.recordMs(completionCheckTime);
+                recordingHist.recordMs(recordingTime);
+                totalHist.recordNs(ns);
+                frameCounter.fetch_add(1, std::memory_order_relaxed);
+                if (!resultFlag) {
+                    pupilFailCounter.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (!frameComplete) {
+                    incompleteCounter.fetch_add(1, std::memory_order_relaxed);
+                }
+            } else {
+                emptyCounter.fetch_add(1, std::memory_order_relaxed);
             }
-            outSem.release();
             sendOverSign(frameId);
 
         }
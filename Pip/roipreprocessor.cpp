@@ -0,0 +1,150 @@
+#include "roipreprocessor.h"
+#include <algorithm>
+#include <cfloat>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace {
+    // BORDER_REFLECT_101：-1 → 1，n → n - 2
+    inline int reflect101(int index, int size) {
+        if (index < 0) {
+            return -index;
+        }
+        if (index >= size) {
+            return 2 * (size - 1) - index;
+        }
+        return index;
+    }
+
+    // 向量读写越过行尾的余量
+    const int SIMD_SLACK = 64;
+}
+
+void RoiPreprocessor::process(const cv::Mat& roi, cv::Mat& blur, cv::Mat& glintMask, int glintThreshold)
+{
+    const int width = roi.cols;
+    const int height = roi.rows;
+    uchar threshold = (uchar)std::max(0, std::min(255, glintThreshold));
+
+    // 太小的区域反射边界退化，直接走原组合
+    if (roi.type() != CV_8UC1 || width < 3 || height < 3) {
+        cv::Mat normalized;
+        cv::normalize(roi, normalized, 0, 255, cv::NORM_MINMAX);
+        cv::GaussianBlur(normalized, blur, cv::Size(5, 5), 0);
+        cv::threshold(blur, glintMask, threshold, 255, cv::THRESH_BINARY);
+        return;
+    }
+
+    // 与 cv::normalize 相同：dst = src * scale + shift，最值相等时全部为 0
+    double minValue, maxValue;
+    cv::minMaxIdx(roi, &minValue, &maxValue);
+    double range = maxValue - minValue;
+    double scale = 255.0 * (range > DBL_EPSILON ? 1.0 / range : 0.0);
+    double shift = -minValue * scale;
+
+    blur.create(height, width, CV_8UC1);
+    glintMask.create(height, width, CV_8UC1);
+    m_padded.resize(width + 4 + SIMD_SLACK);
+    m_ring.resize(5 * (size_t)(width + SIMD_SLACK));
+
+    int ringRow[5] = { -1, -1, -1, -1, -1 };
+    const ushort* rows[5];
+
+    for (int y = 0; y < height; ++y) {
+        // 需要的 5 个源行总在 [y-2, y+2] 内（反射后也是），按行号模 5 放入环形缓冲，每行只算一次
+        for (int k = 0; k < 5; ++k) {
+            int sourceRow = reflect101(y - 2 + k, height);
+            int slot = sourceRow % 5;
+            ushort* ringData = m_ring.data() + (size_t)slot * (width + SIMD_SLACK);
+            if (ringRow[slot] != sourceRow) {
+                uchar* padded = m_padded.data();
+                normalizeRow(roi.ptr<uchar>(sourceRow), padded + 2, width, (float)scale, (float)shift);
+                padded[0] = padded[4];
+                padded[1] = padded[3];
+                padded[width + 2] = padded[width];
+                padded[width + 3] = padded[width - 1];
+                horizontalRow(padded, ringData, width);
+                ringRow[slot] = sourceRow;
+            }
+            rows[k] = ringData;
+        }
+        verticalRow(rows, blur.ptr<uchar>(y), glintMask.ptr<uchar>(y), width, threshold);
+    }
+}
+
+void RoiPreprocessor::normalizeRow(const uchar* src, uchar* dst, int width, float scale, float shift) const
+{
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::v_uint8::nlanes;
+    const int quarter = cv::v_uint32::nlanes;
+    cv::v_float32 vScale = cv::vx_setall_f32(scale);
+    cv::v_float32 vShift = cv::vx_setall_f32(shift);
+    for (; x <= width - lanes; x += lanes) {
+        cv::v_int32 r0 = cv::v_round(cv::v_fma(cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::vx_load_expand_q(src + x))), vScale, vShift));
+        cv::v_int32 r1 = cv::v_round(cv::v_fma(cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::vx_load_expand_q(src + x + quarter))), vScale, vShift));
+        cv::v_int32 r2 = cv::v_round(cv::v_fma(cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::vx_load_expand_q(src + x + 2 * quarter))), vScale, vShift));
+        cv::v_int32 r3 = cv::v_round(cv::v_fma(cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::vx_load_expand_q(src + x + 3 * quarter))), vScale, vShift));
+        cv::v_store(dst + x, cv::v_pack_u(cv::v_pack(r0, r1), cv::v_pack(r2, r3)));
+    }
+#endif
+    for (; x < width; ++x) {
+        dst[x] = cv::saturate_cast<uchar>(cvRound(src[x] * scale + shift));
+    }
+}
+
+void RoiPreprocessor::horizontalRow(const uchar* padded, ushort* dst, int width) const
+{
+    // [1 4 6 4 1]，最大 255 * 16，16 位不溢出
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::v_uint16::nlanes;
+    for (; x <= width - lanes; x += lanes) {
+        cv::v_uint16 a0 = cv::vx_load_expand(padded + x);
+        cv::v_uint16 a1 = cv::vx_load_expand(padded + x + 1);
+        cv::v_uint16 a2 = cv::vx_load_expand(padded + x + 2);
+        cv::v_uint16 a3 = cv::vx_load_expand(padded + x + 3);
+        cv::v_uint16 a4 = cv::vx_load_expand(padded + x + 4);
+        cv::v_store(dst + x, a0 + a4 + ((a1 + a3) << 2) + (a2 << 2) + (a2 << 1));
+    }
+#endif
+    for (; x < width; ++x) {
+        const uchar* p = padded + x;
+        dst[x] = (ushort)(p[0] + p[4] + 4 * (p[1] + p[3]) + 6 * p[2]);
+    }
+}
+
+void RoiPreprocessor::verticalRow(const ushort* const rows[5], uchar* blur, uchar* mask, int width, uchar threshold) const
+{
+    // 垂直方向同一个核，总和最大 255 * 256 = 65280，加上舍入的 128 仍在 16 位内；
+    // (sum + 128) >> 8 与 OpenCV 8 位定点高斯的舍入一致
+    const ushort* r0 = rows[0];
+    const ushort* r1 = rows[1];
+    const ushort* r2 = rows[2];
+    const ushort* r3 = rows[3];
+    const ushort* r4 = rows[4];
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::v_uint8::nlanes;
+    const int half = cv::v_uint16::nlanes;
+    cv::v_uint16 vRound = cv::vx_setall_u16(128);
+    cv::v_uint8 vThreshold = cv::vx_setall_u8(threshold);
+    for (; x <= width - lanes; x += lanes) {
+        cv::v_uint16 lo = cv::vx_load(r0 + x) + cv::vx_load(r4 + x)
+                          + ((cv::vx_load(r1 + x) + cv::vx_load(r3 + x)) << 2)
+                          + (cv::vx_load(r2 + x) << 2) + (cv::vx_load(r2 + x) << 1) + vRound;
+        cv::v_uint16 hi = cv::vx_load(r0 + x + half) + cv::vx_load(r4 + x + half)
+                          + ((cv::vx_load(r1 + x + half) + cv::vx_load(r3 + x + half)) << 2)
+                          + (cv::vx_load(r2 + x + half) << 2) + (cv::vx_load(r2 + x + half) << 1) + vRound;
+        cv::v_uint8 value = cv::v_pack(lo >> 8, hi >> 8);
+        cv::v_store(blur + x, value);
+        cv::v_store(mask + x, value > vThreshold);
+    }
+#endif
+    for (; x < width; ++x) {
+        unsigned sum = r0[x] + r4[x] + 4u * (r1[x] + r3[x]) + 6u * r2[x];
+        uchar value = (uchar)((sum + 128) >> 8);
+        blur[x] = value;
+        mask[x] = value > threshold ? 255 : 0;
+    }
+}
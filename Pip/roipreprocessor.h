@@ -0,0 +1,35 @@
+#ifndef ROIPREPROCESSOR_H
+#define ROIPREPROCESSOR_H
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 眼部 ROI 预处理的融合实现：一次求最值，之后一遍完成归一化、5x5 高斯模糊和光斑阈值
+ *
+ * 结果与下面的组合一致（归一化同样按 float 缩放后取整，模糊按 OpenCV 8 位定点的 [1 4 6 4 1]/16
+ * 可分离核和舍入、BORDER_REFLECT_101）：
+ *   cv::normalize(roi, n, 0, 255, cv::NORM_MINMAX);
+ *   cv::GaussianBlur(n, blur, cv::Size(5, 5), 0);
+ *   cv::threshold(blur, glintMask, glintThreshold, 255, cv::THRESH_BINARY);
+ * 原组合把整幅 ROI 读写三遍；这里按行流水：源行归一化后做水平滤波，结果放进 5 行的环形缓冲，
+ * 凑齐 5 行即输出一行模糊图和对应的阈值行，中间结果始终留在 L1/L2 中，ROI 只读一遍、写一遍。
+ * 逐行计算使用 OpenCV 通用 intrinsics，同一份代码编译为 SSE/AVX2/NEON。
+ *
+ * 缓冲区随 ROI 宽度复用，不在每帧分配；一个实例只能在一个线程中使用。
+ */
+class RoiPreprocessor {
+public:
+    // blur、glintMask 按 roi 尺寸（重新）分配，尺寸不变时复用
+    void process(const cv::Mat& roi, cv::Mat& blur, cv::Mat& glintMask, int glintThreshold = 220);
+
+private:
+    void normalizeRow(const uchar* src, uchar* dst, int width, float scale, float shift) const;
+    void horizontalRow(const uchar* padded, ushort* dst, int width) const;
+    void verticalRow(const ushort* const rows[5], uchar* blur, uchar* mask, int width, uchar threshold) const;
+
+    std::vector<uchar> m_padded;     // 归一化后的一行，左右各留 2 像素反射边界
+    std::vector<ushort> m_ring;      // 5 行水平滤波结果
+};
+
+#endif // ROIPREPROCESSOR_H
@@ -0,0 +1,128 @@
+#ifndef ROITRACKER_H
+#define ROITRACKER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <opencv2/core/core.hpp>
+
+/**
+ * 瞳孔 ROI 的帧间跟踪
+ *
+ * 60fps 下瞳孔帧间只移动几个像素，稳定跟踪时不必每帧在整幅图上找最暗区域：
+ * 以上一帧的瞳孔中心加上帧间速度预测本帧位置，只在预测点周围的小窗口里搜索。
+ * 以下情况返回“需要全图搜索”：尚未跟踪上、上一帧 ROI 或瞳孔检测失败（眨眼、遮挡）、
+ * 距上次全图搜索超过 refreshInterval 帧（防止长期锁在错误的暗区上）。
+ *
+ * 位置按原始画面坐标保存，采集端裁剪区域平移后（PipeFrame::cropOrigin 变化）仍然有效。
+ * 帧级并行时多个 worker 共用一个实例，所有接口加锁；乱序到达的旧帧结果被忽略。
+ */
+class RoiTracker {
+public:
+    void setEnabled(bool enabled) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_enabled = enabled;
+        m_valid = false;
+    }
+
+    bool isEnabled() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_enabled;
+    }
+
+    // 每隔多少帧强制做一次全图搜索，<= 0 表示不强制
+    void setRefreshInterval(int frames) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_refreshInterval = frames;
+    }
+
+    // 本帧的搜索窗口（图像坐标）；返回 false 表示需要全图搜索
+    bool searchWindow(int frameId, const cv::Point& cropOrigin, const cv::Size& imageSize, cv::Rect& window) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_enabled || !m_valid
+            || (m_refreshInterval > 0 && frameId - m_lastGlobalFrameId >= m_refreshInterval)) {
+            m_globalSearches.fetch_add(1, std::memory_order_relaxed);
+            m_lastGlobalFrameId = frameId;
+            return false;
+        }
+
+        // 常速度预测；帧级并行时上一帧的结果可能还没出来，按实际相隔的帧数外推
+        int gap = std::max(1, frameId - m_lastFrameId);
+        cv::Point2f predicted = m_center + m_velocity * (float)gap;
+        float speed = std::sqrt(m_velocity.x * m_velocity.x + m_velocity.y * m_velocity.y) * gap;
+        int half = (int)std::ceil(std::max(m_pupilRadius * 1.5f, (float)MIN_HALF_WINDOW) + speed * 2);
+
+        cv::Point center((int)std::lround(predicted.x) - cropOrigin.x, (int)std::lround(predicted.y) - cropOrigin.y);
+        window = cv::Rect(center.x - half, center.y - half, 2 * half, 2 * half)
+                 & cv::Rect(0, 0, imageSize.width, imageSize.height);
+        if (window.width < MIN_HALF_WINDOW || window.height < MIN_HALF_WINDOW) {
+            m_valid = false;
+            m_globalSearches.fetch_add(1, std::memory_order_relaxed);
+            m_lastGlobalFrameId = frameId;
+            return false;
+        }
+        m_trackedSearches.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 瞳孔检测成功：center 为图像坐标的瞳孔中心，radius 为瞳孔半径（像素）
+    void reportSuccess(int frameId, const cv::Point2f& center, float radius, const cv::Point& cropOrigin) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_enabled || (m_valid && frameId <= m_lastFrameId)) {
+            return;
+        }
+        cv::Point2f fullCenter = center + cv::Point2f((float)cropOrigin.x, (float)cropOrigin.y);
+        if (m_valid) {
+            int gap = std::max(1, frameId - m_lastFrameId);
+            cv::Point2f velocity = (fullCenter - m_center) * (1.0f / gap);
+            // 速度平滑一下，单帧的检测抖动不放大窗口
+            m_velocity = m_velocity * 0.5f + velocity * 0.5f;
+        } else {
+            m_velocity = cv::Point2f(0, 0);
+        }
+        m_center = fullCenter;
+        m_pupilRadius = radius > 0 ? radius : m_pupilRadius;
+        m_lastFrameId = frameId;
+        m_valid = true;
+    }
+
+    // ROI 或瞳孔检测失败（眨眼、遮挡、跟丢），下一帧回到全图搜索
+    void reportFailure(int frameId) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_valid && frameId >= m_lastFrameId) {
+            m_valid = false;
+            m_lostEvents.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_valid = false;
+        m_lastFrameId = -1;
+        m_lastGlobalFrameId = -1;
+    }
+
+    uint64_t trackedSearches() const { return m_trackedSearches.load(std::memory_order_relaxed); }
+    uint64_t globalSearches() const { return m_globalSearches.load(std::memory_order_relaxed); }
+    uint64_t lostEvents() const { return m_lostEvents.load(std::memory_order_relaxed); }
+
+private:
+    static const int MIN_HALF_WINDOW = 48;
+
+    mutable std::mutex m_mutex;
+    bool m_enabled = false;
+    bool m_valid = false;
+    int m_refreshInterval = 300;
+    int m_lastFrameId = -1;
+    int m_lastGlobalFrameId = -1;
+    cv::Point2f m_center;           // 原始画面坐标
+    cv::Point2f m_velocity;         // 像素/帧
+    float m_pupilRadius = 40;
+
+    std::atomic<uint64_t> m_trackedSearches{0};
+    std::atomic<uint64_t> m_globalSearches{0};
+    std::atomic<uint64_t> m_lostEvents{0};
+};
+
+#endif // ROITRACKER_H
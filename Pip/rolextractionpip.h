@@ -12,23 +12,33 @@ public:
     rolExtractionPip() : QObject(), AbstractPipe("RolPipe", PIPE_PROCESS_E) {};
 
     void pipe(QSemaphore& inSem, QSemaphore& outSem) {
-        FrameImage* pInFrame = (FrameImage*)m_pInImage;
-        FrameImage* pOutFrame = (FrameImage*)m_pOutImage;
+        // 子步骤直方图在循环外注册，循环内只做无锁记录
+        LatencyHistogram& darkestHist = stepHistogram("darkestDetection");
+        LatencyHistogram& roiCreationHist = stepHistogram("roiCreation");
+        LatencyHistogram& roiSaveHist = stepHistogram("roiSave");
+        LatencyHistogram& coordinateHist = stepHistogram("coordinateAdjust");
+        LatencyHistogram& roiExtractionHist = stepHistogram("roiExtraction");
+        LatencyHistogram& transferHist = stepHistogram("imageTransfer");
+        LatencyHistogram& recordingHist = stepHistogram("recording");
+        LatencyHistogram& totalHist = stepHistogram("total");
+        std::atomic<uint64_t>& frameCounter = stageCounter("frames");
+        std::atomic<uint64_t>& emptyCounter = stageCounter("emptyFrames");
 
         while (!exit()) {
-            inSem.acquire();
+            PipeFrame inFrame;
+            if (!popInFrame(inSem, inFrame)) {
+                continue;
+            }
             QElapsedTimer totalTimer, stepTimer;
             totalTimer.start();
-            int frameId;
-            if (pInFrame && !pInFrame->image.empty()) {
-                // ========== 1. 图像克隆 ==========
-                stepTimer.start();
-                cv::Mat src = pInFrame->image.clone();
-                frameId = pInFrame->frameId;
-                double cloneTime = stepTimer.nsecsElapsed() / 1e6;
+            int frameId = inFrame.frameId;
+            if (!inFrame.image.empty()) {
+                // 采集帧同时被 SharedPipelineData 引用，本级只读：暗区检测、ROI 创建与提取都不写原图，
+                // 共享引用即可，无需 clone；ROI 图像交给下一级后同样只读
+                cv::Mat src = inFrame.image;
 
                 // ========== 2. 最暗区域检测 ==========
-                stepTimer.restart();
+                stepTimer.start();
                 cv::Point darkestCenter = rolExtraction.getDarkestArea(src);
                 double darkestDetectionTime = stepTimer.nsecsElapsed() / 1e6;
 
@@ -59,8 +69,15 @@ public:
 
                 // ========== 7. 图像传递 ==========
                 stepTimer.restart();
-                pOutFrame->image = rolImage;
-                pOutFrame->frameId = frameId;
+                PipeFrame outFrame;
+                outFrame.image = rolImage;
+                outFrame.frameId = frameId;
+                outFrame.captureTimeUs = inFrame.captureTimeUs;
+                outFrame.sequence = inFrame.sequence;
+                outFrame.intervalUs = inFrame.intervalUs;
+                outFrame.droppedBefore = inFrame.droppedBefore;
+                outFrame.cropOrigin = inFrame.cropOrigin;
+                pushOutFrame(std::move(outFrame), outSem);
                 double imageTransferTime = stepTimer.nsecsElapsed() / 1e6;
 
                 // ========== 8. 时间记录 ==========
@@ -70,12 +87,19 @@ public:
                 SharedPipelineData::setTime(frameId, 2, totalMs);
                 double recordingTime = stepTimer.nsecsElapsed() / 1e6;
 
-                // ========== 性能报告输出 ==========
-                static int frameCount = 0;
-                frameCount++;
-
+                // ========== 性能指标 ==========
+                darkestHist.recordMs(darkestDetectionTime);
+                roiCreationHist.recordMs(roiCreationTime);
+                roiSaveHist.recordMs(roiSaveTime);
+                coordinateHist.recordMs(coordinateAdjustTime);
+                roiExtractionHist.recordMs(roiExtractionTime);
+                transferHist.recordMs(imageTransferTime);
+                recordingHist.recordMs(recordingTime);
+                totalHist.recordNs(ns);
+                frameCounter.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                emptyCounter.fetch_add(1, std::memory_order_relaxed);
             }
-            outSem.release();
             sendOverSign(frameId);
 
         }
@@ -6,43 +6,55 @@
 #include "spotextraction.h"
 #include "sharedpipelinedate.h"
 #include "smartspotprocessor.h"
+#include "roipreprocessor.h"
+#include "glintextractor.h"
 
 class SpotExtractionPip:public QObject, public AbstractPipe
 {
     Q_OBJECT
 public:
     SpotExtractionPip():  QObject(),AbstractPipe("SpotPipe", PIPE_PROCESS_E){};
-    void pipe(QSemaphore & inSem, QSemaphore & outSem){
-        FrameImage* pInFrame = (FrameImage*)m_pInImage;
-        FrameImage* pOutFrame = (FrameImage*)m_pOutImage;
 
-        while(!exit()) {
-            inSem.acquire();
+    // 光斑提取改用游程连通域标记（GlintExtractor），默认关闭；需在管道启动前设置
+    void setFastGlintExtraction(bool enabled) { m_fastGlintExtraction = enabled; }
+    bool fastGlintExtraction() const { return m_fastGlintExtraction; }
+
+    void pipe(QSemaphore & inSem, QSemaphore & outSem){
+        // 子步骤直方图在循环外注册，循环内只做无锁记录
+        LatencyHistogram& preprocessHist = stepHistogram("preprocess");
+        LatencyHistogram& frameDataHist = stepHistogram("getFrameData");
+        LatencyHistogram& lightDetectionHist = stepHistogram("lightDetection");
+        LatencyHistogram& spotProcessingHist = stepHistogram("spotProcessing");
+        LatencyHistogram& coordinateHist = stepHistogram("coordinateAdjust");
+        LatencyHistogram& arrangementHist = stepHistogram("spotArrangement");
+        LatencyHistogram& storageHist = stepHistogram("dataStorage");
+        LatencyHistogram& finalHist = stepHistogram("finalProcessing");
+        LatencyHistogram& recordingHist = stepHistogram("recording");
+        LatencyHistogram& totalHist = stepHistogram("total");
+        std::atomic<uint64_t>& frameCounter = stageCounter("frames");
+        std::atomic<uint64_t>& emptyCounter = stageCounter("emptyFrames");
+        std::atomic<uint64_t>& missingDataCounter = stageCounter("missingFrameData");
+
+        while (!exit()) {
+            PipeFrame inFrame;
+            if (!popInFrame(inSem, inFrame)) {
+                continue;
+            }
             QElapsedTimer totalTimer, stepTimer;
             totalTimer.start();
-            int frameId;
-            if(pInFrame && !pInFrame->image.empty()) {
-                // ========== 1. 图像克隆 ==========
-                stepTimer.start();
-                cv::Mat src = pInFrame->image.clone();
-                frameId = pInFrame->frameId;
-                double cloneTime = stepTimer.nsecsElapsed() / 1e6;
+            int frameId = inFrame.frameId;
+            if (!inFrame.image.empty()) {
+                // 上一级的 ROI 图像可能是采集帧的视图，只读；预处理结果写入本级复用的缓冲区，
+                // ROI 尺寸不变时不再分配
+                const cv::Mat& src = inFrame.image;
+                cv::Mat& blur = m_blur;
+                cv::Mat& outPutLightImage = m_lightImage;
 
                 // ========== 2. 图像预处理 ==========
-                cv::Mat blur, outPutLightImage;
-                stepTimer.restart();
-                cv::normalize(src, src, 0, 255, cv::NORM_MINMAX);
-                double normalizeTime = stepTimer.nsecsElapsed() / 1e6;
-
-                // 2.2 高斯模糊
-                stepTimer.restart();
-                cv::GaussianBlur(src, blur, cv::Size(5, 5), 0);
-                double blurTime = stepTimer.nsecsElapsed() / 1e6;
-
-                // 2.3 二值化
-                stepTimer.restart();
-                cv::threshold(blur, outPutLightImage, 220, 255, cv::THRESH_BINARY);
-                double thresholdTime1 = stepTimer.nsecsElapsed() / 1e6;
+                // 归一化 + 高斯模糊 + 光斑二值化融合为一遍
+                stepTimer.start();
+                m_preprocessor.process(src, blur, outPutLightImage, 220);
+                double preprocessTime = stepTimer.nsecsElapsed() / 1e6;
 
                 // ========== 3. 获取帧数据 ==========
                 stepTimer.restart();
@@ -50,28 +62,24 @@ public:
                 bool hasFrameData = SharedPipelineData::getFrameData(frameId, frameData);
                 double getFrameDataTime = stepTimer.nsecsElapsed() / 1e6;
 
-                cv::Mat processedBlur;
                 double lightDetectionTime = 0.0;
                 double spotProcessingTime = 0.0;
                 double coordinateAdjustTime = 0.0;
                 double spotArrangementTime = 0.0;
                 double dataStorageTime = 0.0;
-                double cloneTime2 = 0.0;
 
                 if(hasFrameData) {
                     // ========== 4. 光斑检测 ==========
                     stepTimer.restart();
-                    std::vector<Circle> lightSpots = spotExtraction.lightExpection(outPutLightImage, frameData.darkPoint);
+                    std::vector<Circle> lightSpots = m_fastGlintExtraction
+                            ? m_glintExtractor.extract(outPutLightImage, frameData.darkPoint)
+                            : spotExtraction.lightExpection(outPutLightImage, frameData.darkPoint);
                     lightDetectionTime = stepTimer.nsecsElapsed() / 1e6;
 
-                    // ========== 5. 图像克隆2 ==========
-                    stepTimer.restart();
-                    processedBlur = blur.clone();
-                    cloneTime2 = stepTimer.nsecsElapsed() / 1e6;
-
                     // ========== 6. 光斑处理 ==========
+                    // 模糊图是本级的缓冲区，之后只用于生成瞳孔二值图，直接在上面修补光斑，无需 clone
                     stepTimer.restart();
-                    spotProcessor.processLightSpots(processedBlur, lightSpots,
+                    spotProcessor.processLightSpots(blur, lightSpots,
                                                     cv::Point2f(frameData.darkPoint.x, frameData.darkPoint.y), 30);
                     spotProcessingTime = stepTimer.nsecsElapsed() / 1e6;
 
@@ -99,14 +107,20 @@ public:
 
                 // ========== 10. 最终处理 ==========
                 stepTimer.restart();
-                if(hasFrameData && !processedBlur.empty()) {
-                    cv::threshold(processedBlur, pOutFrame->image, 100, 255, cv::THRESH_BINARY);
-                } else {
-                    // 容错：使用原始模糊图像
-                    cv::threshold(blur, pOutFrame->image, 100, 255, cv::THRESH_BINARY);
+                // 二值图随帧交给下一级，每帧新分配，不能使用本级的复用缓冲区
+                PipeFrame outFrame;
+                cv::threshold(blur, outFrame.image, 100, 255, cv::THRESH_BINARY);
+                if(!hasFrameData) {
+                    // 容错：使用未修补光斑的模糊图像
                     qDebug() << "Frame" << frameId << "FrameData failed, using fallback processing";
                 }
-                pOutFrame->frameId = frameId;
+                outFrame.frameId = frameId;
+                outFrame.captureTimeUs = inFrame.captureTimeUs;
+                outFrame.sequence = inFrame.sequence;
+                outFrame.intervalUs = inFrame.intervalUs;
+                outFrame.droppedBefore = inFrame.droppedBefore;
+                outFrame.cropOrigin = inFrame.cropOrigin;
+                pushOutFrame(std::move(outFrame), outSem);
                 double finalProcessingTime = stepTimer.nsecsElapsed() / 1e6;
 
                 // ========== 11. 时间记录 ==========
@@ -116,12 +130,25 @@ public:
                 SharedPipelineData::setTime(frameId, 3, totalMs);
                 double recordingTime = stepTimer.nsecsElapsed() / 1e6;
 
-                // ========== 性能报告输出 ==========
-                static int frameCount = 0;
-                frameCount++;
-
+                // ========== 性能指标 ==========
+                preprocessHist.recordMs(preprocessTime);
+                frameDataHist.recordMs(getFrameDataTime);
+                if (hasFrameData) {
+                    lightDetectionHist.recordMs(lightDetectionTime);
+                    spotProcessingHist.recordMs(spotProcessingTime);
+                    coordinateHist.recordMs(coordinateAdjustTime);
+                    arrangementHist.recordMs(spotArrangementTime);
+                    storageHist.recordMs(dataStorageTime);
+                } else {
+                    missingDataCounter.fetch_add(1, std::memory_order_relaxed);
+                }
+                finalHist.recordMs(finalProcessingTime);
+                recordingHist.recordMs(recordingTime);
+                totalHist.recordNs(ns);
+                frameCounter.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                emptyCounter.fetch_add(1, std::memory_order_relaxed);
             }
-            outSem.release();
             sendOverSign(frameId);
         }
 
@@ -134,6 +161,12 @@ private:
     int maxSpotsCount;
     int minRequiredSpots = 4; // 期望找到4个光斑
     SmartSpotProcessor spotProcessor; // 光斑处理器
+    // 预处理及其复用缓冲区，只在本级线程中使用
+    RoiPreprocessor m_preprocessor;
+    GlintExtractor m_glintExtractor;
+    bool m_fastGlintExtraction = false;
+    cv::Mat m_blur;
+    cv::Mat m_lightImage;
     bool debugFlag = 0;
 };
 
@@ -0,0 +1,192 @@
+#include "taskscheduler.h"
+
+namespace {
+// 当前线程所属的调度器及其工作线程序号，外部线程为 nullptr/-1
+thread_local const TaskScheduler* t_scheduler = nullptr;
+thread_local int t_workerIndex = -1;
+}
+
+TaskScheduler::TaskScheduler(int workerCount)
+{
+    if (workerCount < 0) {
+        workerCount = 0;
+    }
+    for (int i = 0; i <= workerCount; ++i) {
+        m_queues.emplace_back(new TaskQueue());
+    }
+    for (int i = 0; i < workerCount; ++i) {
+        m_threads.emplace_back(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+int TaskScheduler::currentWorkerIndex() const
+{
+    return t_scheduler == this ? t_workerIndex : -1;
+}
+
+void TaskScheduler::submit(Task task)
+{
+    int index = currentWorkerIndex();
+    TaskQueue& queue = index >= 0 ? *m_queues[index] : *m_queues.back();
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queuedTasks.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_wake.notify_one();
+}
+
+bool TaskScheduler::popLocal(int index, Task& task)
+{
+    TaskQueue& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool TaskScheduler::steal(int thief, Task& task)
+{
+    // 从 thief 之后的队列开始轮询，注入队列也在其中
+    int count = (int)m_queues.size();
+    for (int offset = 1; offset <= count; ++offset) {
+        int victim = (thief + offset + count) % count;
+        if (victim == thief) {
+            continue;
+        }
+        TaskQueue& queue = *m_queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::runOne()
+{
+    int index = currentWorkerIndex();
+    int self = index >= 0 ? index : (int)m_queues.size() - 1;
+
+    Task task;
+    if (!popLocal(self, task) && !steal(self, task)) {
+        return false;
+    }
+    m_queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+    task();
+    return true;
+}
+
+void TaskScheduler::workerLoop(int index)
+{
+    t_scheduler = this;
+    t_workerIndex = index;
+
+    while (true) {
+        if (runOne()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() {
+            return m_stop || m_queuedTasks.load(std::memory_order_relaxed) > 0;
+        });
+        if (m_stop) {
+            return;
+        }
+    }
+}
+
+TaskGraph::NodeId TaskGraph::addTask(std::function<void()> fn, std::initializer_list<NodeId> deps)
+{
+    NodeId id = (NodeId)m_nodes.size();
+    std::unique_ptr<Node> node(new Node());
+    node->fn = std::move(fn);
+    node->depCount = (int)deps.size();
+    for (NodeId dep : deps) {
+        m_nodes[dep]->successors.push_back(id);
+    }
+    m_nodes.push_back(std::move(node));
+    return id;
+}
+
+void TaskGraph::run(TaskScheduler& scheduler)
+{
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    m_error = nullptr;
+    m_unfinished.store((int)m_nodes.size());
+    for (auto& node : m_nodes) {
+        node->remaining.store(node->depCount);
+    }
+    for (NodeId id = 0; id < (NodeId)m_nodes.size(); ++id) {
+        if (m_nodes[id]->depCount == 0) {
+            schedule(scheduler, id);
+        }
+    }
+
+    // 调用线程协助执行，直到所有节点完成
+    while (m_unfinished.load() > 0) {
+        if (scheduler.runOne()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_doneMutex);
+        m_doneCond.wait(lock, [this]() { return m_unfinished.load() == 0; });
+    }
+
+    if (m_error) {
+        std::rethrow_exception(m_error);
+    }
+}
+
+void TaskGraph::schedule(TaskScheduler& scheduler, NodeId id)
+{
+    scheduler.submit([this, &scheduler, id]() {
+        Node& node = *m_nodes[id];
+        try {
+            node.fn();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            if (!m_error) {
+                m_error = std::current_exception();
+            }
+        }
+        for (NodeId next : node.successors) {
+            if (m_nodes[next]->remaining.fetch_sub(1) == 1) {
+                schedule(scheduler, next);
+            }
+        }
+        finishNode();
+    });
+}
+
+void TaskGraph::finishNode()
+{
+    if (m_unfinished.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+        m_doneCond.notify_all();
+    }
+}
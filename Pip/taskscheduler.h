@@ -0,0 +1,95 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 轻量级工作窃取任务调度器
+ *
+ * - 每个工作线程一个双端队列：本线程从尾部取（LIFO，缓存友好），
+ *   空闲线程从其他队列头部窃取（FIFO）
+ * - 外部线程提交的任务进入注入队列
+ * - 等待方（TaskGraph::run 的调用线程）通过 runOne() 协助执行，不空转
+ *
+ * 面向单帧内的细粒度分叉/汇合，任务数很少，队列用互斥锁保护即可。
+ */
+class TaskScheduler {
+public:
+    typedef std::function<void()> Task;
+
+    // workerCount 为额外工作线程数，调用线程本身也会参与执行
+    explicit TaskScheduler(int workerCount);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    void submit(Task task);
+
+    // 尝试取一个任务在当前线程执行，没有可执行的任务时返回 false
+    bool runOne();
+
+    int workerCount() const { return (int)m_threads.size(); }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int index);
+    bool popLocal(int index, Task& task);
+    bool steal(int thief, Task& task);
+    int currentWorkerIndex() const;
+
+    std::vector<std::unique_ptr<TaskQueue>> m_queues;   // 最后一个是外部注入队列
+    std::vector<std::thread> m_threads;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_queuedTasks{0};
+    bool m_stop = false;
+};
+
+/**
+ * 任务依赖图（DAG）
+ *
+ * 图只构建一次，每帧调用 run() 复用；节点在所有前驱完成后才被提交。
+ * run() 阻塞到全部节点完成，节点抛出的第一个异常会在 run() 中重新抛出。
+ */
+class TaskGraph {
+public:
+    typedef int NodeId;
+
+    NodeId addTask(std::function<void()> fn, std::initializer_list<NodeId> deps = {});
+    void run(TaskScheduler& scheduler);
+    size_t size() const { return m_nodes.size(); }
+
+private:
+    struct Node {
+        std::function<void()> fn;
+        std::vector<NodeId> successors;
+        int depCount = 0;
+        std::atomic<int> remaining{0};
+    };
+
+    void schedule(TaskScheduler& scheduler, NodeId id);
+    void finishNode();
+
+    std::vector<std::unique_ptr<Node>> m_nodes;
+    std::atomic<int> m_unfinished{0};
+    std::mutex m_doneMutex;
+    std::condition_variable m_doneCond;
+    std::mutex m_errorMutex;
+    std::exception_ptr m_error;
+};
+
+#endif // TASKSCHEDULER_H
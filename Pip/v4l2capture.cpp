@@ -0,0 +1,536 @@
+#include "v4l2capture.h"
+#include "foreignmat.h"
+#ifdef HAVE_LIBJPEG_TURBO
+#include "jpegroidecoder.h"
+#endif
+#include <QDebug>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/videodev2.h>
+#include <opencv2/imgcodecs.hpp>
+
+namespace {
+
+// 驱动手里至少保留的缓冲区数，低于此值时零拷贝回退为拷贝
+const int MIN_DRIVER_BUFFERS = 2;
+
+int xioctl(int fd, unsigned long request, void* arg)
+{
+    int ret;
+    do {
+        ret = ioctl(fd, request, arg);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+uint32_t toFourcc(V4l2Capture::PixelFormat format)
+{
+    switch (format) {
+    case V4l2Capture::FORMAT_GREY:  return V4L2_PIX_FMT_GREY;
+    case V4l2Capture::FORMAT_YUYV:  return V4L2_PIX_FMT_YUYV;
+    case V4l2Capture::FORMAT_MJPEG: return V4L2_PIX_FMT_MJPEG;
+    default:                        return 0;
+    }
+}
+
+int64_t steadyNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+struct V4l2Capture::Buffers {
+    struct Mapping {
+        void* start = MAP_FAILED;
+        size_t length = 0;
+    };
+
+    std::mutex mutex;
+    int fd = -1;
+    bool streaming = false;
+    std::vector<Mapping> maps;
+    int outstanding = 0;    // 已交给下游、尚未归还驱动的缓冲区数
+
+    ~Buffers() {
+        for (const Mapping& map : maps) {
+            if (map.start != MAP_FAILED) {
+                munmap(map.start, map.length);
+            }
+        }
+    }
+
+    // 调用方需持有 mutex
+    bool queue(int index) {
+        v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = index;
+        return xioctl(fd, VIDIOC_QBUF, &buf) == 0;
+    }
+
+    // 零拷贝帧的最后一个持有者释放时调用；设备已关闭则只做计数
+    void release(int index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        outstanding--;
+        if (streaming) {
+            queue(index);
+        }
+    }
+};
+
+V4l2Capture::V4l2Capture()
+{
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+V4l2Capture::~V4l2Capture()
+{
+    close();
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
+}
+
+const char* V4l2Capture::formatName(PixelFormat format)
+{
+    switch (format) {
+    case FORMAT_GREY:  return "GREY";
+    case FORMAT_YUYV:  return "YUYV";
+    case FORMAT_MJPEG: return "MJPEG";
+    default:           return "AUTO";
+    }
+}
+
+std::string V4l2Capture::findDevice(const std::string& nameOrPath)
+{
+    if (nameOrPath.compare(0, 5, "/dev/") == 0) {
+        return nameOrPath;
+    }
+
+    for (int i = 0; i < 64; ++i) {
+        std::string path = "/dev/video" + std::to_string(i);
+        int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        v4l2_capability cap;
+        memset(&cap, 0, sizeof(cap));
+        bool matched = false;
+        if (xioctl(fd, VIDIOC_QUERYCAP, &cap) == 0) {
+            uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+            std::string card(reinterpret_cast<const char*>(cap.card));
+            matched = (caps & V4L2_CAP_VIDEO_CAPTURE) && (nameOrPath.empty() || card == nameOrPath);
+        }
+        ::close(fd);
+
+        if (matched) {
+            return path;
+        }
+    }
+    return std::string();
+}
+
+std::string V4l2Capture::deviceIdentity(const std::string& device)
+{
+    int fd = ::open(device.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return std::string();
+    }
+    v4l2_capability cap;
+    memset(&cap, 0, sizeof(cap));
+    std::string identity;
+    if (xioctl(fd, VIDIOC_QUERYCAP, &cap) == 0) {
+        identity = device + "|" + reinterpret_cast<const char*>(cap.card)
+                   + "|" + reinterpret_cast<const char*>(cap.bus_info);
+    }
+    ::close(fd);
+    return identity;
+}
+
+bool V4l2Capture::open(const std::string& device, int width, int height, double fps,
+                       PixelFormat preferred, int bufferCount)
+{
+    close();
+
+    m_fd = ::open(device.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        qDebug() << "V4L2: 无法打开设备" << device.c_str() << strerror(errno);
+        return false;
+    }
+
+    v4l2_capability cap;
+    memset(&cap, 0, sizeof(cap));
+    if (xioctl(m_fd, VIDIOC_QUERYCAP, &cap) < 0) {
+        qDebug() << "V4L2: 不是视频设备" << device.c_str();
+        close();
+        return false;
+    }
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+        qDebug() << "V4L2: 设备不支持流式采集" << device.c_str();
+        close();
+        return false;
+    }
+
+    // 协商格式：GREY 可零拷贝，YUYV 只需抽取 Y，MJPEG 需要解码但占用 USB 带宽最少
+    bool negotiated = false;
+    if (preferred != FORMAT_AUTO) {
+        negotiated = negotiate(preferred, width, height, fps);
+    } else {
+        const PixelFormat candidates[] = { FORMAT_GREY, FORMAT_YUYV, FORMAT_MJPEG };
+        for (PixelFormat candidate : candidates) {
+            if (negotiate(candidate, width, height, fps) && m_fps + 0.5 >= fps) {
+                negotiated = true;
+                break;
+            }
+        }
+        // 都达不到目标帧率时，退而求其次接受帧率最高的格式
+        if (!negotiated) {
+            PixelFormat best = FORMAT_AUTO;
+            double bestFps = 0;
+            for (PixelFormat candidate : candidates) {
+                if (negotiate(candidate, width, height, fps) && m_fps > bestFps) {
+                    best = candidate;
+                    bestFps = m_fps;
+                }
+            }
+            negotiated = best != FORMAT_AUTO && negotiate(best, width, height, fps);
+        }
+    }
+
+    if (!negotiated) {
+        qDebug() << "V4L2: 设备不支持" << width << "x" << height << "的 GREY/YUYV/MJPEG 格式";
+        close();
+        return false;
+    }
+
+    if (!startStreaming(bufferCount)) {
+        close();
+        return false;
+    }
+
+    qDebug() << "V4L2: 打开" << device.c_str() << (const char*)cap.card
+             << m_width << "x" << m_height << "@" << m_fps << "fps" << formatName(m_format)
+             << "缓冲区" << (int)m_buffers->maps.size();
+    return true;
+}
+
+bool V4l2Capture::negotiate(PixelFormat format, int width, int height, double fps)
+{
+    uint32_t fourcc = toFourcc(format);
+
+    v4l2_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = width;
+    fmt.fmt.pix.height = height;
+    fmt.fmt.pix.pixelformat = fourcc;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (xioctl(m_fd, VIDIOC_S_FMT, &fmt) < 0) {
+        return false;
+    }
+
+    // 驱动不支持时会改成别的格式或尺寸，视为协商失败
+    if (fmt.fmt.pix.pixelformat != fourcc ||
+        (int)fmt.fmt.pix.width != width || (int)fmt.fmt.pix.height != height) {
+        return false;
+    }
+
+    m_format = format;
+    m_width = width;
+    m_height = height;
+    m_bytesPerLine = fmt.fmt.pix.bytesperline;
+    if (m_bytesPerLine <= 0) {
+        m_bytesPerLine = (format == FORMAT_YUYV) ? width * 2 : width;
+    }
+
+    // 帧率：驱动支持 timeperframe 时设置，并读回实际值
+    m_fps = fps;
+    v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(m_fd, VIDIOC_G_PARM, &parm) == 0 &&
+        (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)) {
+        parm.parm.capture.timeperframe.numerator = 1000;
+        parm.parm.capture.timeperframe.denominator = (uint32_t)std::lround(fps * 1000);
+        if (xioctl(m_fd, VIDIOC_S_PARM, &parm) == 0 &&
+            parm.parm.capture.timeperframe.numerator > 0) {
+            m_fps = (double)parm.parm.capture.timeperframe.denominator /
+                    parm.parm.capture.timeperframe.numerator;
+        }
+    }
+    return true;
+}
+
+bool V4l2Capture::startStreaming(int bufferCount)
+{
+    v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = bufferCount;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(m_fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        qDebug() << "V4L2: 申请驱动缓冲区失败" << strerror(errno);
+        return false;
+    }
+
+    std::shared_ptr<Buffers> buffers = std::make_shared<Buffers>();
+    buffers->fd = m_fd;
+    buffers->maps.resize(req.count);
+
+    for (uint32_t i = 0; i < req.count; ++i) {
+        v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(m_fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            qDebug() << "V4L2: 查询缓冲区失败" << i;
+            return false;
+        }
+
+        void* start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, buf.m.offset);
+        if (start == MAP_FAILED) {
+            qDebug() << "V4L2: mmap 失败" << strerror(errno);
+            return false;
+        }
+        buffers->maps[i].start = start;
+        buffers->maps[i].length = buf.length;
+    }
+
+    std::lock_guard<std::mutex> lock(buffers->mutex);
+    for (uint32_t i = 0; i < req.count; ++i) {
+        if (!buffers->queue(i)) {
+            qDebug() << "V4L2: 缓冲区入队失败" << i;
+            return false;
+        }
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(m_fd, VIDIOC_STREAMON, &type) < 0) {
+        qDebug() << "V4L2: 启动数据流失败" << strerror(errno);
+        return false;
+    }
+    buffers->streaming = true;
+    m_buffers = buffers;
+    return true;
+}
+
+void V4l2Capture::close()
+{
+    if (m_buffers) {
+        std::lock_guard<std::mutex> lock(m_buffers->mutex);
+        if (m_buffers->streaming) {
+            v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            xioctl(m_fd, VIDIOC_STREAMOFF, &type);
+            m_buffers->streaming = false;
+        }
+        if (m_buffers->outstanding > 0) {
+            qDebug() << "V4L2: 关闭时仍有" << m_buffers->outstanding
+                     << "帧在下游使用，映射延后释放；释放前重新打开设备会失败（EBUSY）";
+        }
+    }
+    // 在途帧各自持有 Buffers，映射在最后一帧释放后才解除
+    m_buffers.reset();
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void V4l2Capture::wakeup()
+{
+    if (m_wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ret = ::write(m_wakeFd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+bool V4l2Capture::read(Frame& frame, int timeoutMs)
+{
+    int index;
+    size_t bytesUsed;
+    if (!dequeue(timeoutMs, index, bytesUsed, frame.timestampUs, frame.sequence)) {
+        return false;
+    }
+    std::shared_ptr<Buffers> buffers = m_buffers;
+    frame.cropped = false;
+    frame.region = cv::Rect(0, 0, m_width, m_height);
+    frame.scaleDenom = 1;
+
+    if (m_format == FORMAT_GREY && m_zeroCopy) {
+        bool zeroCopy;
+        {
+            std::lock_guard<std::mutex> lock(buffers->mutex);
+            int driverHeld = (int)buffers->maps.size() - buffers->outstanding - 1;
+            zeroCopy = driverHeld >= MIN_DRIVER_BUFFERS;
+            if (zeroCopy) {
+                buffers->outstanding++;
+            }
+        }
+        if (zeroCopy) {
+            frame.image = ForeignMatAllocator::wrap(m_height, m_width, CV_8UC1,
+                                                    buffers->maps[index].start, m_bytesPerLine,
+                                                    [buffers, index]() { buffers->release(index); });
+            m_zeroCopyFrames.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    if (m_format == FORMAT_MJPEG && m_payloadTap && bytesUsed > 0) {
+        m_payloadTap(static_cast<const uint8_t*>(buffers->maps[index].start), bytesUsed, frame.timestampUs);
+    }
+
+    bool ok = convert(index, bytesUsed, frame);
+    {
+        std::lock_guard<std::mutex> lock(buffers->mutex);
+        buffers->queue(index);
+    }
+    if (ok) {
+        m_copiedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ok;
+}
+
+bool V4l2Capture::discard(int timeoutMs)
+{
+    int index;
+    size_t bytesUsed;
+    int64_t timestampUs;
+    int64_t sequence;
+    if (!dequeue(timeoutMs, index, bytesUsed, timestampUs, sequence)) {
+        return false;
+    }
+    std::shared_ptr<Buffers> buffers = m_buffers;
+    if (m_format == FORMAT_MJPEG && m_payloadTap && bytesUsed > 0) {
+        m_payloadTap(static_cast<const uint8_t*>(buffers->maps[index].start), bytesUsed, timestampUs);
+    }
+    std::lock_guard<std::mutex> lock(buffers->mutex);
+    buffers->queue(index);
+    return true;
+}
+
+bool V4l2Capture::dequeue(int timeoutMs, int& index, size_t& bytesUsed, int64_t& timestampUs, int64_t& sequence)
+{
+    if (m_fd < 0 || !m_buffers) {
+        return false;
+    }
+
+    pollfd fds[2];
+    fds[0].fd = m_fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    int ret = poll(fds, m_wakeFd >= 0 ? 2 : 1, timeoutMs);
+    if (ret <= 0) {
+        return false;
+    }
+    if (m_wakeFd >= 0 && (fds[1].revents & POLLIN)) {
+        uint64_t value;
+        ssize_t drained = ::read(m_wakeFd, &value, sizeof(value));
+        (void)drained;
+        return false;
+    }
+    if (!(fds[0].revents & POLLIN)) {
+        if (fds[0].revents & (POLLERR | POLLHUP)) {
+            qDebug() << "V4L2: 设备错误或已断开";
+        }
+        return false;
+    }
+
+    v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(m_fd, VIDIOC_DQBUF, &buf) < 0) {
+        return false;
+    }
+
+    if (buf.flags & V4L2_BUF_FLAG_ERROR) {
+        std::lock_guard<std::mutex> lock(m_buffers->mutex);
+        m_buffers->queue(buf.index);
+        return false;
+    }
+
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        timestampUs = (int64_t)buf.timestamp.tv_sec * 1000000 + buf.timestamp.tv_usec;
+    } else {
+        timestampUs = steadyNowUs();
+    }
+    index = buf.index;
+    bytesUsed = buf.bytesused;
+    sequence = buf.sequence;
+    return true;
+}
+
+bool V4l2Capture::convert(int index, size_t bytesUsed, Frame& frame)
+{
+    void* data = m_buffers->maps[index].start;
+
+#ifdef HAVE_LIBJPEG_TURBO
+    if (m_format == FORMAT_MJPEG && m_jpegDecoder) {
+        frame.cropped = true;
+        cv::Rect roi = m_jpegDecoder->roi() & frame.region;
+        if (roi.area() > 0) {
+            frame.region = roi;
+        }
+        frame.scaleDenom = m_jpegDecoder->scaleDenom();
+        return bytesUsed > 0 && m_jpegDecoder->decode(static_cast<const uint8_t*>(data), bytesUsed, frame.image);
+    }
+#endif
+
+    // GREY/YUYV 按裁剪区域只拷贝需要的部分；YUYV 每个像素的第 0 通道都是 Y，任意列起点都可以
+    cv::Rect crop = m_crop & frame.region;
+    if (crop.area() > 0 && crop != frame.region && m_format != FORMAT_MJPEG) {
+        frame.cropped = true;
+        frame.region = crop;
+    }
+    const cv::Rect& region = frame.region;
+
+    cv::Mat& gray = frame.image;
+
+    switch (m_format) {
+    case FORMAT_GREY: {
+        cv::Mat src(m_height, m_width, CV_8UC1, data, m_bytesPerLine);
+        gray = m_pool.acquire(region.height, region.width, CV_8UC1);
+        src(region).copyTo(gray);
+        return true;
+    }
+    case FORMAT_YUYV: {
+        cv::Mat src(m_height, m_width, CV_8UC2, data, m_bytesPerLine);
+        gray = m_pool.acquire(region.height, region.width, CV_8UC1);
+        cv::extractChannel(src(region), gray, 0);
+        return true;
+    }
+    case FORMAT_MJPEG: {
+        gray = m_pool.acquire(m_height, m_width, CV_8UC1);
+        if (bytesUsed == 0) {
+            return false;
+        }
+        // 尺寸一致时 imdecode 直接解码进池中的缓冲区
+        cv::Mat jpeg(1, (int)bytesUsed, CV_8UC1, data);
+        cv::imdecode(jpeg, cv::IMREAD_GRAYSCALE, &gray);
+        return !gray.empty() && gray.rows == m_height && gray.cols == m_width;
+    }
+    default:
+        return false;
+    }
+}
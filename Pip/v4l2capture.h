@@ -0,0 +1,128 @@
+#ifndef V4L2CAPTURE_H
+#define V4L2CAPTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "framebufferpool.h"
+
+class JpegRoiDecoder;
+
+/**
+ * Linux V4L2 原生采集
+ *
+ * - 驱动缓冲区 mmap 到用户空间，VIDIOC_DQBUF 取帧，不经过 FFmpeg 解复用
+ * - 按请求的宽高/帧率协商 GREY、YUYV 或 MJPEG，输出统一为 CV_8UC1 灰度图
+ * - GREY：默认拷贝到缓冲池（按 setCrop 的区域）后立即归还驱动。
+ *   setZeroCopy(true) 时直接把驱动缓冲区包装成 cv::Mat 交给下游，最后一个持有者释放时
+ *   自动 VIDIOC_QBUF 归还；驱动手里剩余缓冲区不足时改为拷贝，避免下游积压导致驱动丢帧。
+ *   零拷贝帧持有设备映射，close() 时仍在下游的帧会让 vb2 队列保持占用，
+ *   在它们全部释放之前重新打开设备（REQBUFS）会返回 EBUSY
+ * - YUYV：只抽取 Y 分量到缓冲池；MJPEG：灰度解码到缓冲池（或交给 JpegRoiDecoder
+ *   只解码眼部区域）；两者取完立即归还
+ * - 每帧携带内核缓冲区时间戳（CLOCK_MONOTONIC，与 std::chrono::steady_clock 同基准）和驱动帧序号
+ */
+class V4l2Capture {
+public:
+    enum PixelFormat {
+        FORMAT_AUTO = 0,    // 依次尝试 GREY、YUYV、MJPEG，取第一个满足宽高和帧率的
+        FORMAT_GREY,
+        FORMAT_YUYV,
+        FORMAT_MJPEG
+    };
+
+    struct Frame {
+        cv::Mat image;              // 灰度图
+        int64_t timestampUs = 0;    // 内核采集时间戳（微秒）
+        int64_t sequence = -1;      // 驱动帧序号，不连续说明驱动丢过帧
+        bool cropped = false;       // 已裁到 ROI（JpegRoiDecoder 区域解码或按 setCrop 拷贝）
+        cv::Rect region;            // image 覆盖的原始画面区域
+        int scaleDenom = 1;         // image 相对原始画面的缩小倍数（JPEG DCT 缩放）
+    };
+
+    V4l2Capture();
+    ~V4l2Capture();
+
+    V4l2Capture(const V4l2Capture&) = delete;
+    V4l2Capture& operator=(const V4l2Capture&) = delete;
+
+    // 设备名解析：已经是 /dev/videoN 时原样返回，否则按 VIDIOC_QUERYCAP 的 card 名匹配，
+    // 找不到返回空串
+    static std::string findDevice(const std::string& nameOrPath);
+
+    // 设备身份：“设备节点|card|bus_info”（VIDIOC_QUERYCAP），同一物理摄像头不论用序号还是名称打开都相同，
+    // 节点重新编号后也不会与其他摄像头混淆；查询失败返回空串
+    static std::string deviceIdentity(const std::string& device);
+
+    bool open(const std::string& device, int width, int height, double fps,
+              PixelFormat preferred = FORMAT_AUTO, int bufferCount = 4);
+    void close();
+    bool isOpened() const { return m_fd >= 0; }
+
+    // 等待下一帧，超时、被 wakeup() 打断或出错时返回 false
+    bool read(Frame& frame, int timeoutMs = 1000);
+
+    // 等待下一帧并直接归还驱动，不解码不拷贝（MJPEG 负载仍交给 tap）；暂停时保持驱动队列新鲜
+    bool discard(int timeoutMs = 1000);
+
+    // 打断正在 read() 中等待的线程，可在任意线程调用
+    void wakeup();
+
+    // MJPEG 负载在解码、归还驱动之前交给 tap（录制用），参数为数据、长度、内核时间戳
+    typedef std::function<void(const uint8_t*, size_t, int64_t)> PayloadTap;
+    void setPayloadTap(PayloadTap tap) { m_payloadTap = std::move(tap); }
+
+    // MJPEG 改由该解码器按其 ROI/缩放解码，nullptr 恢复整帧解码；需在采集线程外、开始读帧前设置
+    void setJpegDecoder(JpegRoiDecoder* decoder) { m_jpegDecoder = decoder; }
+
+    // 需要拷贝的帧（YUYV 抽取亮度、GREY 回退拷贝、imdecode 之外）只拷贝该区域，空矩形表示整帧。
+    // 零拷贝帧仍是整帧，由调用方按 region 取视图。与 read() 在同一线程调用
+    void setCrop(const cv::Rect& crop) { m_crop = crop; }
+
+    // GREY 格式零拷贝交付，默认关闭；开启时调用方须保证关闭设备前下游已释放所有帧。需在 open() 前设置
+    void setZeroCopy(bool enabled) { m_zeroCopy = enabled; }
+    bool zeroCopy() const { return m_zeroCopy; }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    double fps() const { return m_fps; }
+    PixelFormat format() const { return m_format; }
+    static const char* formatName(PixelFormat format);
+
+    // 零拷贝交付 / 回退为拷贝的帧数
+    uint64_t zeroCopyFrames() const { return m_zeroCopyFrames.load(std::memory_order_relaxed); }
+    uint64_t copiedFrames() const { return m_copiedFrames.load(std::memory_order_relaxed); }
+
+private:
+    struct Buffers;  // mmap 区域与 fd，由在途的零拷贝帧共同持有
+
+    bool negotiate(PixelFormat format, int width, int height, double fps);
+    bool startStreaming(int bufferCount);
+    // 等待并取出一个填好的驱动缓冲区，调用方负责归还
+    bool dequeue(int timeoutMs, int& index, size_t& bytesUsed, int64_t& timestampUs, int64_t& sequence);
+    bool convert(int index, size_t bytesUsed, Frame& frame);
+
+    int m_fd = -1;
+    int m_wakeFd = -1;
+    std::shared_ptr<Buffers> m_buffers;
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_bytesPerLine = 0;
+    double m_fps = 0;
+    PixelFormat m_format = FORMAT_AUTO;
+
+    FrameBufferPool m_pool;   // YUYV/MJPEG 及回退拷贝的输出缓冲
+    JpegRoiDecoder* m_jpegDecoder = nullptr;
+    cv::Rect m_crop;
+    bool m_zeroCopy = false;
+    PayloadTap m_payloadTap;
+    std::atomic<uint64_t> m_zeroCopyFrames{0};
+    std::atomic<uint64_t> m_copiedFrames{0};
+};
+
+#endif // V4L2CAPTURE_H
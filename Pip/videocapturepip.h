@@ -10,6 +10,22 @@
 #include <QTimer>
 #include <QElapsedTimer>
 #include "sharedpipelinedate.h"
+#include "framebufferpool.h"
+#include "foreignmat.h"
+#include "decodedelaytracker.h"
+#include "packetrecorder.h"
+#include "framearchive.h"
+#include "captureprofilecache.h"
+#include "framegapdetector.h"
+#include "eyecropestimator.h"
+#include <condition_variable>
+#include <deque>
+#ifdef HAVE_V4L2
+#include "v4l2capture.h"
+#endif
+#ifdef HAVE_LIBJPEG_TURBO
+#include "jpegroidecoder.h"
+#endif
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -26,12 +42,26 @@ class videoCapturePip: public QObject, public AbstractPipe
 {
     Q_OBJECT
 public:
+    // FFmpeg 解码线程模式
+    typedef enum DECODE_MODE_E {
+        DECODE_FRAME_THREADS_E = 0,  // 帧线程：吞吐最高，但多出最多 thread_count-1 帧延迟
+        DECODE_SLICE_THREADS_E,      // 片线程：单帧内并行，无额外帧延迟（解码器不支持时退化为单线程）
+        DECODE_SINGLE_THREAD_E,      // 单线程解码
+        DECODE_DEMUX_THREAD_E        // 独立解复用线程读包，采集线程单线程解码
+    } DECODE_MODE_E;
+
+    // 文件/回放源的送帧节奏
+    typedef enum REPLAY_PACE_E {
+        REPLAY_REALTIME_E = 0,       // 按帧率（回放按录制时间戳）送帧，文件结束后从头循环
+        REPLAY_UNTHROTTLED_E         // 不限速：下游处理完即送下一帧，满队列时等待而不丢帧，文件结束即停止
+    } REPLAY_PACE_E;
+
     videoCapturePip():QObject(),AbstractPipe("videoCapturePipi", PIPE_SOURCE_E),
         sourceType(0), cameraIndex(0),
         m_width(1280), m_height(720), m_fps(60),
         m_isFrameReady(false), m_formatContext(nullptr), m_codecContext(nullptr),
-        m_codec(nullptr), m_frame(nullptr), m_frameRGB(nullptr),
-        m_packet(nullptr), m_swsContext(nullptr), m_buffer(nullptr),
+        m_codec(nullptr), m_frame(nullptr),
+        m_packet(nullptr), m_swsContext(nullptr),
         m_videoStreamIndex(-1), m_isopened(false)
     {
         avdevice_register_all();
@@ -59,6 +89,48 @@ public:
         m_fps = fps;
     }
 
+    // 设置送入下游的眼部区域（采集开始前调用），超出画面的部分自动裁掉；
+    // 启用自动裁剪时作为寻找眼睛的搜索区域
+    void setCaptureRoi(const cv::Rect& roi){
+        m_captureRoi = roi;
+    }
+
+    // 自动裁剪：采集开始后的 warmupFrames 帧在搜索区域内定位眼睛，之后只输出眼睛周围
+    // margin 像素的区域，并推给 MJPEG 区域解码和 V4L2 拷贝，头部漂移时缓慢平移。
+    // 启动阶段输出整个搜索区域且不写帧归档；裁剪区域变化时 PipeFrame::cropOrigin 随之变化
+    void setAutoCrop(bool enabled, int warmupFrames = 30, int margin = 300){
+        m_autoCropWarmup = warmupFrames;
+        m_autoCropMargin = margin;
+        m_autoCropEnabled = enabled;
+        m_autoCropRestart = true;
+    }
+
+    // 当前送入下游的区域（原始画面坐标），可在任意线程调用
+    cv::Rect currentCrop() {
+        std::lock_guard<std::mutex> lock(m_cropMutex);
+        return m_activeCrop;
+    }
+
+    // MJPEG 改用 libjpeg-turbo 只解码眼部区域（需 CONFIG+=turbojpeg）。
+    // scaleDenom 取 1/2/4/8，做 DCT 域缩小，下游坐标随之同比缩小。采集开始前调用
+    void setJpegRoiDecode(bool enabled, int scaleDenom = 1){
+#ifndef HAVE_LIBJPEG_TURBO
+        if (enabled) {
+            qDebug() << "未启用 libjpeg-turbo（CONFIG+=turbojpeg），继续使用 FFmpeg 解码";
+        }
+        enabled = false;
+#endif
+        m_useJpegRoiDecoder = enabled;
+        m_jpegScaleDenom = scaleDenom;
+    }
+
+    // V4L2 GREY 格式零拷贝交付（驱动缓冲区直接交给下游），默认关闭。
+    // 零拷贝帧会被 SharedPipelineData、管道队列和显示持有，关闭时未释放完则重新打开设备失败；
+    // 只在确认下游不跨关闭持有帧时开启。采集开始前调用
+    void setV4l2ZeroCopy(bool enabled){
+        m_v4l2ZeroCopy = enabled;
+    }
+
     void resetSource(){
         cleanup();
         qDebug()<<"视频源清理完毕";
@@ -66,11 +138,15 @@ public:
     void closeCamera() {
         qDebug() << "开始关闭摄像头流程...";
 
-        // 设置关闭标志，让 pipe 线程停止读取
+        // 设置关闭标志，让 pipe 线程停止读取；阻塞中的读取由中断回调立即打断
         m_shouldClose = true;
+        m_stateSignal.notifyAll();
+#ifdef HAVE_V4L2
+        m_v4l2.wakeup();
+#endif
 
-        // 等待一小段时间，确保 readFrame 不再被调用
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        // 等采集线程真正退出循环，而不是固定等待一段时间
+        waitForCaptureStopped();
 
         // 现在安全地关闭资源
         QMutexLocker locker(&m_mutex);
@@ -81,6 +157,20 @@ public:
             // 标记为未打开状态
             m_isopened = false;
 
+            // 先停预解码和解复用线程，它们会访问下面要释放的解码器和格式上下文
+            stopPrefetchThread();
+            stopDemuxThread();
+            m_replay.close();
+
+            // 先放掉本对象持有的最近一帧，零拷贝帧在这之后才可能随设备一起释放
+            m_currentFrame.release();
+            m_isFrameReady = false;
+
+#ifdef HAVE_V4L2
+            m_v4l2.close();
+#endif
+            m_useV4l2 = false;
+
             // 刷新解码器缓冲区
             if (m_codecContext) {
                 avcodec_send_packet(m_codecContext, nullptr);
@@ -97,16 +187,6 @@ public:
                 m_swsContext = nullptr;
             }
 
-            if (m_buffer) {
-                av_free(m_buffer);
-                m_buffer = nullptr;
-            }
-
-            if (m_frameRGB) {
-                av_frame_free(&m_frameRGB);
-                m_frameRGB = nullptr;
-            }
-
             if (m_frame) {
                 av_frame_free(&m_frame);
                 m_frame = nullptr;
@@ -134,22 +214,13 @@ public:
 
             // 重置其他状态
             m_videoStreamIndex = -1;
-            m_currentFrame.release();
-            m_isFrameReady = false;
 
             qDebug() << (sourceType == 0 ? "摄像头" : "视频文件") << "资源已释放";
         }
 
-        // 重置关闭标志
+        // 重置关闭标志（avformat_close_input 返回时设备已释放）
         m_shouldClose = false;
 
-// Windows下额外等待，确保设备完全释放
-#ifdef _WIN32
-        if (sourceType == 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        }
-#endif
-
         qDebug() << "摄像头关闭流程完成";
     }
 
@@ -160,105 +231,182 @@ public:
         return m_isopened;
     }
 
-    //先关闭当前摄像头，然后重新初始化
+    // 绑定 readFrame 使用的直方图，必须在采集线程开始读帧前调用
+    void bindMetrics() {
+        m_readHist = &stepHistogram("read");
+        m_decodeHist = &stepHistogram("decode");
+        m_convertHist = &stepHistogram("convert");
+        m_readFrameHist = &stepHistogram("readFrame");
+        m_cacheHitCounter = &stageCounter("packetCacheHits");
+        m_demuxDropCounter = &stageCounter("demuxDropped");
+        m_prefetchEmptyCounter = &stageCounter("prefetchEmpty");
+
+        std::string delayStep = "decodeDelay.";
+        delayStep += m_useJpegRoiDecoder ? "turbojpeg" : decodeModeName(m_decodeMode);
+        m_decodeDelayHist = &stepHistogram(delayStep.c_str());
+    }
 
-    bool reopenCamera() {
-        closeCamera();
+    // 帧缓冲池因耗尽而额外分配的次数，稳态下应保持不变
+    uint64_t framePoolGrowCount() const {
+        return m_framePool.growCount();
+    }
 
-        // 等待一小段时间确保资源完全释放
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // 设置解码线程模式（采集开始前调用），各模式的数据包到达 → 帧输出延迟
+    // 记录在 "decodeDelay.<模式名>" 直方图中，便于按摄像头选择延迟最低的配置
+    void setDecodeMode(DECODE_MODE_E mode, int threadCount = 4) {
+        m_decodeMode = mode;
+        m_decodeThreadCount = threadCount > 0 ? threadCount : 1;
+    }
 
-        return initializeFFmpeg();
+    DECODE_MODE_E decodeMode() const {
+        return m_decodeMode;
     }
-    bool initializeFFmpeg(){
-        QMutexLocker locker(&m_mutex);
 
-        if(sourceType == 0) {
-            // 摄像头模式 - MJPEG专用设置
-            const AVInputFormat *inputFormat = av_find_input_format("dshow");
-            if(!inputFormat){
-                qDebug() << "找不到摄像头格式";
-                return false;
-            }
+    static const char* decodeModeName(DECODE_MODE_E mode) {
+        switch (mode) {
+        case DECODE_FRAME_THREADS_E:  return "frameThreads";
+        case DECODE_SLICE_THREADS_E:  return "sliceThreads";
+        case DECODE_SINGLE_THREAD_E:  return "singleThread";
+        case DECODE_DEMUX_THREAD_E:   return "demuxThread";
+        default:                      return "unknown";
+        }
+    }
 
-            QString deviceName = QString("video=%1").arg(m_source.toString());
+    // 设置文件/回放源的送帧节奏（采集开始前调用）。不限速模式用于离线批量处理，
+    // 结束时输出吞吐与各级延迟汇总并发出 replayFinished()；对摄像头无效
+    void setReplayPace(REPLAY_PACE_E pace) {
+        m_replayPace = pace;
+    }
 
-            // MJPEG专用参数设置
-            AVDictionary * options = nullptr;
-            av_dict_set(&options, "video_size",
-                        QString("%1x%2").arg(m_width).arg(m_height).toLocal8Bit().data(), 0);
+    REPLAY_PACE_E replayPace() const {
+        return m_replayPace;
+    }
 
-            // 强制使用MJPEG，这是关键
-            av_dict_set(&options, "vcodec", "mjpeg", 0);
+    // 最近一帧的数据包到达 → 帧输出延迟（毫秒），无法对应时为负
+    double lastDecodeDelayMs() const {
+        return m_output.decodeDelayUs / 1000.0;
+    }
 
-            // MJPEG专用缓冲区设置 - 需要足够大来处理高质量JPEG帧
-            av_dict_set(&options, "rtbufsize", "5M", 0);      // 减小缓冲区到5M
-            av_dict_set(&options, "buffer_size", "2M", 0);    // 额外缓冲区控制
-            av_dict_set(&options, "fflags", "+nobuffer+flush_packets", 0);  // 禁用内部缓冲
-            av_dict_set(&options, "flags", "+low_delay", 0);  // 低延迟模式
+    // 采集端检测到的累计丢帧数和重复帧数（只在采集线程中更新）
+    uint64_t droppedFrameCount() const {
+        return m_gapDetector.droppedFrames();
+    }
 
-            // 其他设置也调整为更激进的低延迟配置：
-            av_dict_set(&options, "probesize", "1M", 0);           // 从10M减小到1M
-            av_dict_set(&options, "analyzeduration", "500000", 0); // 从2秒减小到0.5秒
-            av_dict_set(&options, "max_delay", "100000", 0);       // 从0.5秒减小到0.1秒
+    uint64_t duplicateFrameCount() const {
+        return m_gapDetector.duplicateFrames();
+    }
 
-            qDebug() << "🔧 使用小缓冲区配置 - rtbufsize: 5M, buffer_size: 2M";
+    // 最近一帧在流时间基下的 pts，未知时为 AV_NOPTS_VALUE
+    int64_t lastFramePts() const {
+        return m_output.pts;
+    }
 
+    // 文件/回放源的预解码：后台线程提前解码最多 depth 帧排队，文件结束时的定位/回到开头也在后台完成，
+    // 采集线程只取现成的帧（采集开始前调用，对摄像头无效）
+    void setFilePrefetch(bool enabled, size_t depth = 8) {
+        m_prefetchEnabled = enabled;
+        m_prefetchDepth = depth < 1 ? 1 : depth;
+    }
 
-            qDebug() << "打开MJPEG摄像头" << deviceName;
-            qDebug() << "参数：" << m_width << "x" << m_height << "@" << m_fps << "fps";
+    // 把解码前的原始数据包连同采集时间戳录制到 path，不解码也不重新编码。
+    // 源已打开时立即开始，否则在下次打开时开始；用 setSource(2, path) 回放
+    void startRecording(const QString& path) {
+        QMutexLocker locker(&m_mutex);
+        m_recordPath = path;
+        if (m_isopened) {
+            openRecorderForCurrentSource();
+        }
+    }
 
-            int ret = avformat_open_input(&m_formatContext,
-                                          deviceName.toLocal8Bit().data(),
-                                          inputFormat,
-                                          &options);
-            av_dict_free(&options);
+    void stopRecording() {
+        QMutexLocker locker(&m_mutex);
+        m_recordPath.clear();
+        m_recorder.close();
+    }
 
-            if(ret < 0){
-                char errbuf[AV_ERROR_MAX_STRING_SIZE];
-                av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-                qDebug() << "无法打开摄像头:" << errbuf;
-                cleanup();
-                return false;
-            }
-        } else {
-            // 文件模式保持不变
-            QString filePath = m_source.toString();
-            int ret = avformat_open_input(&m_formatContext, filePath.toLocal8Bit().data(), nullptr, nullptr);
-            if(ret < 0){
-                char errbuf[AV_ERROR_MAX_STRING_SIZE];
-                av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-                qDebug() << "无法打开文件:" << errbuf;
-                cleanup();
-                return false;
-            }
-            qDebug() << "打开文件成功:" << filePath;
+    bool isRecording() const {
+        return m_recorder.isOpen();
+    }
+
+    // 把裁剪后送入管道的灰度帧写入预处理帧归档（frameArchivePip 回放），
+    // 帧尺寸取第一帧的尺寸，之后尺寸不同的帧不写入
+    void startFrameArchive(const QString& path) {
+        std::lock_guard<std::mutex> lock(m_archiveMutex);
+        m_archiveWriter.close();
+        m_archivePath = path;
+        m_archiveRequested = !path.isEmpty();
+    }
+
+    void stopFrameArchive() {
+        std::lock_guard<std::mutex> lock(m_archiveMutex);
+        m_archiveRequested = false;
+        m_archivePath.clear();
+        m_archiveWriter.close();
+    }
+
+    bool isArchiving() const {
+        return m_archiveRequested;
+    }
+
+    // 当前摄像头是否走原生 V4L2 采集（否则为 FFmpeg）
+    bool isNativeV4l2() const {
+        return m_useV4l2;
+    }
+
+    //先关闭当前摄像头，然后重新初始化
+
+    bool reopenCamera() {
+        closeCamera();
+        return initializeFFmpeg();
+    }
+    bool initializeFFmpeg(){
+        QMutexLocker locker(&m_mutex);
+        m_endOfStream = false;
+        m_decoderDraining = false;
+        m_resumeFlushPending = false;
+        m_awaitKeyframe = false;
+
+        // 上次按缓存参数打开后一帧也没解出来，缓存已不可信，本次重新探测
+        if (m_profileFromCache && !m_profileConfirmed && !m_profileKey.isEmpty()) {
+            qDebug() << "缓存的采集参数未能解码，清除后重新探测";
+            CaptureProfileCache::remove(m_profileKey);
         }
+        m_profileKey.clear();
+        m_profileFromCache = false;
+        m_profileConfirmed = false;
 
-        // 查找流信息
-        int ret = avformat_find_stream_info(m_formatContext, nullptr);
-        if(ret < 0){
-            qDebug() << "无法获取流信息";
-            cleanup();
-            return false;
+#ifdef HAVE_LIBJPEG_TURBO
+        m_jpegDecoder.setRoi(m_captureRoi);
+        m_jpegDecoder.setScaleDenom(m_jpegScaleDenom);
+#endif
+        {
+            // 重新打开后按当前裁剪区域解码
+            std::lock_guard<std::mutex> lock(m_cropMutex);
+            m_decodeCropChanged = m_decodeCrop.area() > 0;
         }
 
-        // 查找视频流
-        m_videoStreamIndex = -1;
-        for(unsigned int i = 0; i < m_formatContext->nb_streams; i++){
-            if(m_formatContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO){
-                m_videoStreamIndex = i;
-                break;
-            }
+#ifdef HAVE_V4L2
+        // Linux 摄像头优先走原生 V4L2，打不开时再回退到 FFmpeg 的 v4l2 输入
+        if (sourceType == 0 && openV4l2Camera()) {
+            openRecorderForCurrentSource();
+            m_isopened = true;
+            m_stateSignal.notifyAll();
+            return true;
         }
-        if(m_videoStreamIndex == -1){
-            qDebug() << "未找到视频流";
-            cleanup();
+#endif
+
+        if (sourceType == 2) {
+            if (!openReplaySource()) {
+                return false;
+            }
+        } else if (!openFormatInput()) {
             return false;
         }
 
         // 获取解码器 - MJPEG专用设置
-        AVCodecParameters *codecpar = m_formatContext->streams[m_videoStreamIndex]->codecpar;
+        const AVCodecParameters *codecpar = (sourceType == 2)
+                ? m_replay.codecParameters()
+                : m_formatContext->streams[m_videoStreamIndex]->codecpar;
         m_codec = (AVCodec *)avcodec_find_decoder(codecpar->codec_id);
         if(!m_codec){
             qDebug() << "未找到解码器";
@@ -277,9 +425,23 @@ public:
         // 复制参数
         avcodec_parameters_to_context(m_codecContext, codecpar);
 
-        // MJPEG解码器专用设置
-        m_codecContext->thread_count = 4;  // 增加线程数处理MJPEG
-        m_codecContext->thread_type = FF_THREAD_FRAME;  // 只用帧线程，避免片线程问题
+        // 解码线程设置
+        switch (m_decodeMode) {
+        case DECODE_FRAME_THREADS_E:
+            m_codecContext->thread_count = m_decodeThreadCount;
+            m_codecContext->thread_type = FF_THREAD_FRAME;
+            break;
+        case DECODE_SLICE_THREADS_E:
+            m_codecContext->thread_count = m_decodeThreadCount;
+            m_codecContext->thread_type = FF_THREAD_SLICE;
+            m_codecContext->flags |= AV_CODEC_FLAG_LOW_DELAY;
+            break;
+        default:
+            m_codecContext->thread_count = 1;
+            m_codecContext->thread_type = 0;
+            m_codecContext->flags |= AV_CODEC_FLAG_LOW_DELAY;
+            break;
+        }
 
         // MJPEG错误处理设置
         m_codecContext->error_concealment = FF_EC_GUESS_MVS | FF_EC_DEBLOCK;  // 错误掩盖
@@ -294,7 +456,7 @@ public:
         // 设置错误容忍度
         m_codecContext->err_recognition = AV_EF_IGNORE_ERR; // 忽略错误继续解码
 
-        ret = avcodec_open2(m_codecContext, m_codec, nullptr);
+        int ret = avcodec_open2(m_codecContext, m_codec, nullptr);
         if(ret < 0){
             qDebug() << "无法打开解码器";
             cleanup();
@@ -303,29 +465,50 @@ public:
 
         // 分配帧和数据包
         m_frame = av_frame_alloc();
-        m_frameRGB = av_frame_alloc();
         m_packet = av_packet_alloc();
 
-        if(!m_frame || !m_frameRGB || !m_packet){
+        if(!m_frame || !m_packet){
             qDebug() << "无法分配帧内存";
             cleanup();
             return false;
         }
 
-        // 计算灰度帧缓冲区大小
-        int numBytes = av_image_get_buffer_size(AV_PIX_FMT_GRAY8,
-                                                m_codecContext->width,
-                                                m_codecContext->height, 1);
-        m_buffer = (uint8_t *)av_malloc(numBytes * sizeof(uint8_t));
+        if(!createSwsContext(m_codecContext->width, m_codecContext->height, m_codecContext->pix_fmt)){
+            qDebug() << "无法初始化图像转换上下文";
+            cleanup();
+            return false;
+        }
+
+        m_decodeDelay.clear();
+        if (m_decodeMode == DECODE_DEMUX_THREAD_E && sourceType != 2) {
+            startDemuxThread();
+        }
+        openRecorderForCurrentSource();
+
+        m_isopened = true;
+        m_stateSignal.notifyAll();
+        qDebug() << "MJPEG初始化成功";
+        qDebug() << "解码模式" << decodeModeName(m_decodeMode)
+                 << "实际线程数" << m_codecContext->thread_count
+                 << "线程类型" << m_codecContext->active_thread_type;
+
+        AVRational frameRate = m_formatContext ? m_formatContext->streams[m_videoStreamIndex]->r_frame_rate
+                                               : AVRational{0, 0};
+        if(frameRate.den != 0) {
+            double actualFrameRate = (double)frameRate.num / frameRate.den;
+            qDebug() << "实际帧率" << actualFrameRate << "fps";
+        }
+        qDebug() << "像素格式" << av_get_pix_fmt_name(m_codecContext->pix_fmt);
 
-        // 设置灰度帧数据指针
-        av_image_fill_arrays(m_frameRGB->data, m_frameRGB->linesize, m_buffer,
-                             AV_PIX_FMT_GRAY8, m_codecContext->width, m_codecContext->height, 1);
+        return true;
+    }
 
+    // 灰度转换上下文；格式或尺寸与现有上下文相同时直接复用
+    bool createSwsContext(int width, int height, AVPixelFormat srcFormat) {
         // 初始化转换上下文 - MJPEG专用
-        m_swsContext = sws_getContext(
-            m_codecContext->width, m_codecContext->height, m_codecContext->pix_fmt,
-            m_codecContext->width, m_codecContext->height, AV_PIX_FMT_GRAY8,
+        m_swsContext = sws_getCachedContext(m_swsContext,
+            width, height, srcFormat,
+            width, height, AV_PIX_FMT_GRAY8,
             SWS_BILINEAR | SWS_ACCURATE_RND,  // 高质量转换
             nullptr, nullptr, nullptr);
 
@@ -348,89 +531,281 @@ public:
                 qDebug() << "MJPEG色彩空间设置失败，使用默认";
             }
         }
+        m_swsWidth = width;
+        m_swsHeight = height;
+        m_swsFormat = srcFormat;
+        return m_swsContext != nullptr;
+    }
 
-        if(!m_swsContext){
-            qDebug() << "无法初始化图像转换上下文";
-            cleanup();
+    // 打开摄像头/视频文件的解复用器并找到视频流，失败时已清理
+    bool openFormatInput(){
+        // 预先分配上下文以挂上中断回调，关闭/退出时可打断阻塞的打开和读取
+        m_formatContext = avformat_alloc_context();
+        if (!m_formatContext) {
+            qDebug() << "无法分配格式上下文";
             return false;
         }
+        m_formatContext->interrupt_callback.callback = &videoCapturePip::interruptCallback;
+        m_formatContext->interrupt_callback.opaque = this;
 
-        m_isopened = true;
-        qDebug() << "MJPEG初始化成功";
-
-        AVRational frameRate = m_formatContext->streams[m_videoStreamIndex]->r_frame_rate;
-        if(frameRate.den != 0) {
-            double actualFrameRate = (double)frameRate.num / frameRate.den;
-            qDebug() << "实际帧率" << actualFrameRate << "fps";
-        }
-        qDebug() << "像素格式" << av_get_pix_fmt_name(m_codecContext->pix_fmt);
-
-        return true;
-    }
+        if(sourceType == 0) {
+            // 摄像头模式 - MJPEG专用设置
+#ifdef _WIN32
+            const AVInputFormat *inputFormat = av_find_input_format("dshow");
+            QString deviceName = QString("video=%1").arg(m_source.toString());
+#else
+            const AVInputFormat *inputFormat = av_find_input_format("v4l2");
+            QString deviceName = m_source.toString();
+#ifdef HAVE_V4L2
+            deviceName = QString::fromStdString(V4l2Capture::findDevice(deviceName.toStdString()));
+#endif
+#endif
+            if(!inputFormat){
+                qDebug() << "找不到摄像头格式";
+                return false;
+            }
 
+            // MJPEG专用参数设置
+            AVDictionary * options = nullptr;
+            av_dict_set(&options, "video_size",
+                        QString("%1x%2").arg(m_width).arg(m_height).toLocal8Bit().data(), 0);
 
-    cv::Mat readFrame(){
-        if (!m_isopened || m_shouldClose) {
-            return cv::Mat();
-        }
+            // 强制使用MJPEG，这是关键
+#ifdef _WIN32
+            av_dict_set(&options, "vcodec", "mjpeg", 0);
+#else
+            av_dict_set(&options, "input_format", "mjpeg", 0);
+#endif
 
-        if (!m_mutex.tryLock()) {
-            return cv::Mat();
-        }
+            // MJPEG专用缓冲区设置 - 需要足够大来处理高质量JPEG帧
+            av_dict_set(&options, "rtbufsize", "5M", 0);      // 减小缓冲区到5M
+            av_dict_set(&options, "buffer_size", "2M", 0);    // 额外缓冲区控制
+            av_dict_set(&options, "fflags", "+nobuffer+flush_packets", 0);  // 禁用内部缓冲
+            av_dict_set(&options, "flags", "+low_delay", 0);  // 低延迟模式
 
-        struct LockGuard {
-            QMutex* mutex;
-            LockGuard(QMutex* m) : mutex(m) {}
-            ~LockGuard() { if (mutex) mutex->unlock(); }
-        } lockGuard(&m_mutex);
+            // 其他设置也调整为更激进的低延迟配置：
+            av_dict_set(&options, "probesize", "1M", 0);           // 从10M减小到1M
+            av_dict_set(&options, "analyzeduration", "500000", 0); // 从2秒减小到0.5秒
+            av_dict_set(&options, "max_delay", "100000", 0);       // 从0.5秒减小到0.1秒
 
-        // 添加详细的时间测量
-        QElapsedTimer totalTimer, readTimer, decodeTimer, convertTimer;
-        totalTimer.start();
+            qDebug() << "🔧 使用小缓冲区配置 - rtbufsize: 5M, buffer_size: 2M";
 
-        // 统计变量（静态以便跨帧统计）
-        static double totalReadTime = 0;
-        static double totalDecodeTime = 0;
-        static double totalConvertTime = 0;
-        static int frameCount = 0;
-        static int cacheHits = 0;  // 缓冲区命中次数
 
-        int maxAttempts = (sourceType == 0) ? 20 : 5;
-        bool isVideoFile = (sourceType == 1);
+            qDebug() << "打开MJPEG摄像头" << deviceName;
+            qDebug() << "参数：" << m_width << "x" << m_height << "@" << m_fps << "fps";
 
-        for(int attempts = 0; attempts < maxAttempts; attempts++) {
-            readTimer.start();
-            int ret = av_read_frame(m_formatContext, m_packet);
-            double readTime = readTimer.nsecsElapsed() / 1e6;
+            int ret = avformat_open_input(&m_formatContext,
+                                          deviceName.toLocal8Bit().data(),
+                                          inputFormat,
+                                          &options);
+            av_dict_free(&options);
 
-            // 判断是否从缓冲区读取（读取时间特别短）
-            if (readTime < 0.5) {
-                cacheHits++;
+            if(ret < 0){
+                char errbuf[AV_ERROR_MAX_STRING_SIZE];
+                av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+                qDebug() << "无法打开摄像头:" << errbuf;
+                cleanup();
+                return false;
+            }
+        } else {
+            // 文件模式保持不变
+            QString filePath = m_source.toString();
+            int ret = avformat_open_input(&m_formatContext, filePath.toLocal8Bit().data(), nullptr, nullptr);
+            if(ret < 0){
+                char errbuf[AV_ERROR_MAX_STRING_SIZE];
+                av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+                qDebug() << "无法打开文件:" << errbuf;
+                cleanup();
+                return false;
             }
+            qDebug() << "打开文件成功:" << filePath;
+        }
 
+        // 查找流信息：摄像头参数已缓存且与设备报告的一致时跳过（探测需要读取并解码若干帧）
+        if (!(sourceType == 0 && applyCachedProfile())) {
+            int ret = avformat_find_stream_info(m_formatContext, nullptr);
             if(ret < 0){
-                if(ret == AVERROR_EOF && isVideoFile){
-                    qDebug() << "视频文件结束，重新开始播放";
-                    avcodec_flush_buffers(m_codecContext);
-                    int seekRet = avformat_seek_file(m_formatContext, -1,
-                                                     INT64_MIN, 0, INT64_MAX,
-                                                     AVSEEK_FLAG_BACKWARD);
-                    if (seekRet < 0) {
+                qDebug() << "无法获取流信息";
+                cleanup();
+                return false;
+            }
+        }
+
+        // 查找视频流
+        m_videoStreamIndex = -1;
+        for(unsigned int i = 0; i < m_formatContext->nb_streams; i++){
+            if(m_formatContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO){
+                m_videoStreamIndex = i;
+                break;
+            }
+        }
+        if(m_videoStreamIndex == -1){
+            qDebug() << "未找到视频流";
+            cleanup();
+            return false;
+        }
+        return true;
+    }
+
+    // 打开数据包回放文件，解码器参数取自文件头；回放数据包的流序号固定为 0
+    bool openReplaySource(){
+        if (!m_replay.open(m_source.toString())) {
+            return false;
+        }
+        m_videoStreamIndex = 0;
+        return true;
+    }
+
+
+    // 取下一帧，帧的时间戳、序号等随帧信息写入 m_output
+    cv::Mat readFrame(){
+        if (!m_isopened || m_shouldClose) {
+            return cv::Mat();
+        }
+
+        if (m_prefetchThread.joinable()) {
+            return popPrefetchedFrame();
+        }
+
+        if (!m_mutex.tryLock()) {
+            return cv::Mat();
+        }
+
+        struct LockGuard {
+            QMutex* mutex;
+            LockGuard(QMutex* m) : mutex(m) {}
+            ~LockGuard() { if (mutex) mutex->unlock(); }
+        } lockGuard(&m_mutex);
+
+        // 预解码线程在第一次取帧时启动，此时性能指标已经绑定
+        if (m_prefetchEnabled && sourceType != 0 && m_codecContext) {
+            startPrefetchThread();
+            lockGuard.mutex = nullptr;
+            m_mutex.unlock();
+            return popPrefetchedFrame();
+        }
+
+        DecodedFrame decoded = decodeNextFrame();
+        cv::Mat image = decoded.image;
+        decoded.image.release();
+        m_output = decoded;
+        return image;
+    }
+
+    // 解码侧的一帧：先按解码侧的状态（m_last*）产生，交给采集循环时整体写入 m_output
+    struct DecodedFrame {
+        cv::Mat image;
+        int64_t captureTimeUs = 0;
+        int64_t sequence = -1;
+        int64_t pts = AV_NOPTS_VALUE;
+        int64_t decodeDelayUs = -1;
+        bool cropped = false;
+        cv::Rect region;            // image 覆盖的原始画面区域
+        int scaleDenom = 1;         // image 相对原始画面的缩小倍数
+        bool endOfStream = false;   // 预解码队列中的结束标记
+    };
+
+    DecodedFrame decodeNextFrame() {
+        DecodedFrame decoded;
+        decoded.image = decodeNextImage();
+        decoded.captureTimeUs = m_lastCaptureTimeUs;
+        decoded.sequence = m_lastSequence;
+        decoded.pts = m_lastPts;
+        decoded.decodeDelayUs = m_lastDecodeDelayUs;
+        decoded.cropped = m_frameCropped;
+        if (m_frameCropped) {
+            decoded.region = m_frameRegion;
+            decoded.scaleDenom = m_frameScaleDenom;
+        } else {
+            decoded.region = cv::Rect(0, 0, decoded.image.cols, decoded.image.rows);
+        }
+        return decoded;
+    }
+
+    // 读取并解码下一帧，调用方持有 m_mutex 或为预解码线程
+    cv::Mat decodeNextImage(){
+        m_frameCropped = false;
+        applyPendingDecodeCrop();
+
+#ifdef HAVE_V4L2
+        if (m_useV4l2) {
+            return readV4l2Frame();
+        }
+#endif
+
+        // 添加详细的时间测量
+        QElapsedTimer totalTimer, readTimer;
+        totalTimer.start();
+
+        int maxAttempts = (sourceType == 0) ? 20 : 5;
+        bool isVideoFile = (sourceType == 1);
+        bool isReplay = (sourceType == 2);
+
+        // 不限速模式下文件已读完：逐帧取出解码器中剩余的帧，取完即结束
+        if (m_decoderDraining) {
+            return drainAtEndOfStream();
+        }
+
+        if (m_resumeFlushPending) {
+            flushDecoderAfterPause();
+        }
+
+        for(int attempts = 0; attempts < maxAttempts; attempts++) {
+            readTimer.start();
+            int64_t packetTimeUs = 0;
+            int64_t captureTimeUs = 0;
+            int ret = readPacket(m_packet, packetTimeUs, captureTimeUs);
+            double readTime = readTimer.nsecsElapsed() / 1e6;
+
+            // 判断是否从缓冲区读取（读取时间特别短）
+            if (readTime < 0.5 && m_cacheHitCounter) {
+                m_cacheHitCounter->fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if(ret < 0){
+                // 解复用线程模式下文件结束由解复用线程自行处理，只有不限速模式会收到 EOF
+                if(ret == AVERROR_EOF && isUnthrottled()){
+                    qDebug() << (isReplay ? "数据包回放结束" : "视频文件结束") << "，取出解码器剩余帧";
+                    return drainAtEndOfStream();
+                } else if(ret == AVERROR_EOF && isReplay){
+                    qDebug() << "数据包回放结束，从头开始";
+                    avcodec_flush_buffers(m_codecContext);
+                    m_decodeDelay.clear();
+                    if (!m_replay.rewind()) {
+                        return cv::Mat();
+                    }
+                    continue;
+                } else if(ret == AVERROR_EOF && isVideoFile){
+                    qDebug() << "视频文件结束，重新开始播放";
+                    avcodec_flush_buffers(m_codecContext);
+                    m_decodeDelay.clear();
+                    int seekRet = avformat_seek_file(m_formatContext, -1,
+                                                     INT64_MIN, 0, INT64_MAX,
+                                                     AVSEEK_FLAG_BACKWARD);
+                    if (seekRet < 0 && m_prefetchThread.joinable()) {
+                        // 预解码线程不能在自身线程里重建解码器，按文件结束处理
+                        qDebug() << "视频文件定位失败，预解码结束";
+                        m_endOfStream = true;
+                        return cv::Mat();
+                    }
+                    if (seekRet < 0) {
                         QString filePath = m_source.toString();
                         cleanup();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
                         if (!initializeFFmpeg()) {
                             return cv::Mat();
                         }
                     }
-                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
                     continue;
                 } else if (ret == AVERROR(EAGAIN)) {
-                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                    if (waitInterruptible(std::chrono::microseconds(500))) {
+                        return cv::Mat();
+                    }
                     continue;
                 } else {
-                    if (attempts < maxAttempts - 1) {
-                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    if (attempts < maxAttempts - 1 && !stopRequested()) {
+                        if (waitInterruptible(std::chrono::milliseconds(10))) {
+                            return cv::Mat();
+                        }
                         continue;
                     } else {
                         return cv::Mat();
@@ -442,111 +817,212 @@ public:
                 av_packet_unref(m_packet);
                 continue;
             }
-
-            // 解码计时
-            decodeTimer.start();
-            ret = avcodec_send_packet(m_codecContext, m_packet);
-            if(ret < 0){
-                av_packet_unref(m_packet);
-                if (ret == AVERROR(EAGAIN)) {
-                    AVFrame* tempFrame = av_frame_alloc();
-                    if (tempFrame) {
-                        while (avcodec_receive_frame(m_codecContext, tempFrame) == 0) {
-                        }
-                        av_frame_free(&tempFrame);
-                    }
+            if (m_awaitKeyframe) {
+                if (!(m_packet->flags & AV_PKT_FLAG_KEY)) {
+                    av_packet_unref(m_packet);
                     continue;
                 }
-                continue;
+                m_awaitKeyframe = false;
             }
 
-            ret = avcodec_receive_frame(m_codecContext, m_frame);
-            double decodeTime = decodeTimer.nsecsElapsed() / 1e6;
+            // 录制解码前的原始数据包（只增加引用计数，写盘在录制线程）
+            if (m_recorder.isOpen()) {
+                m_recorder.write(m_packet, captureTimeUs);
+            }
 
-            if(ret == 0){
-                if (m_frame->width <= 0 || m_frame->height <= 0) {
-                    av_packet_unref(m_packet);
+#ifdef HAVE_LIBJPEG_TURBO
+            // libjpeg-turbo 直接解码数据包中的眼部区域，跳过 FFmpeg 整帧解码和转换
+            if (m_useJpegRoiDecoder && m_codecContext->codec_id == AV_CODEC_ID_MJPEG) {
+                QElapsedTimer decodeTimer;
+                decodeTimer.start();
+                cv::Mat roiFrame;
+                m_lastPts = m_packet->pts;
+                bool decoded = m_jpegDecoder.decode(m_packet->data, m_packet->size, roiFrame);
+                double decodeTime = decodeTimer.nsecsElapsed() / 1e6;
+                av_packet_unref(m_packet);
+                if (!decoded) {
                     continue;
                 }
 
-                // 转换计时
-                convertTimer.start();
-                int scaleResult = sws_scale(m_swsContext,
-                                            (uint8_t const * const *)m_frame->data,
-                                            m_frame->linesize,
-                                            0,
-                                            m_codecContext->height,
-                                            m_frameRGB->data,
-                                            m_frameRGB->linesize);
+                m_lastDecodeDelayUs = steadyNowUs() - packetTimeUs;
+                if (m_readHist) {
+                    m_readHist->recordMs(readTime);
+                    m_decodeHist->recordMs(decodeTime);
+                    m_decodeDelayHist->recordNs(m_lastDecodeDelayUs * 1000);
+                    m_readFrameHist->recordMs(totalTimer.nsecsElapsed() / 1e6);
+                }
+                m_lastCaptureTimeUs = captureTimeUs;
+                m_lastSequence = -1;
+                m_frameCropped = true;
+                m_frameRegion = m_jpegDecoder.roi() & cv::Rect(0, 0, m_codecContext->width, m_codecContext->height);
+                if (m_frameRegion.area() <= 0) {
+                    m_frameRegion = cv::Rect(0, 0, m_codecContext->width, m_codecContext->height);
+                }
+                m_frameScaleDenom = m_jpegDecoder.scaleDenom();
+                return roiFrame;
+            }
+#endif
+
+            cv::Mat grayFrame = decodePacket(m_packet, packetTimeUs, captureTimeUs);
+            av_packet_unref(m_packet);
+            if (grayFrame.empty()) {
+                continue;
+            }
 
-                double convertTime = convertTimer.nsecsElapsed() / 1e6;
+            // 统计（直方图在 pipe() 开始时绑定）
+            if (m_readHist) {
+                m_readHist->recordMs(readTime);
+                m_readFrameHist->recordMs(totalTimer.nsecsElapsed() / 1e6);
+            }
 
-                if (scaleResult <= 0) {
-                    av_packet_unref(m_packet);
-                    continue;
-                }
+            // slab 在所有下游持有者释放后自动回到池中，Y 平面引用释放后归还解码器
+            return grayFrame;
+        }
 
-                cv::Mat grayFrame(m_codecContext->height, m_codecContext->width, CV_8UC1,
-                                  m_frameRGB->data[0], m_frameRGB->linesize[0]);
+        return cv::Mat();
+    }
 
-                if (grayFrame.empty()) {
-                    av_packet_unref(m_packet);
-                    continue;
+    // 取一个视频流数据包：直接解复用，或从解复用线程的队列中取。
+    // packetTimeUs 为数据包到达时刻（用于解码延迟），captureTimeUs 为帧的采集时间戳，
+    // 直播时两者相同，回放时后者沿用录制时的时间戳
+    int readPacket(AVPacket* packet, int64_t& packetTimeUs, int64_t& captureTimeUs) {
+        int ret;
+        if (sourceType == 2) {
+            ret = m_replay.next(packet, captureTimeUs) ? 0 : AVERROR_EOF;
+            packetTimeUs = steadyNowUs();
+            return ret;
+        }
+        if (m_demuxThread.joinable()) {
+            ret = popDemuxedPacket(packet, packetTimeUs);
+        } else {
+            ret = av_read_frame(m_formatContext, packet);
+            packetTimeUs = steadyNowUs();
+        }
+        captureTimeUs = packetTimeUs;
+        return ret;
+    }
+
+    // 送入一个数据包并尝试取出一帧，转为灰度图；本次没有输出时返回空
+    cv::Mat decodePacket(AVPacket* packet, int64_t packetTimeUs, int64_t captureTimeUs) {
+        QElapsedTimer decodeTimer;
+        decodeTimer.start();
+
+        int ret = avcodec_send_packet(m_codecContext, packet);
+        if(ret < 0){
+            if (ret == AVERROR(EAGAIN)) {
+                AVFrame* tempFrame = av_frame_alloc();
+                if (tempFrame) {
+                    while (avcodec_receive_frame(m_codecContext, tempFrame) == 0) {
+                    }
+                    av_frame_free(&tempFrame);
                 }
+            }
+            return cv::Mat();
+        }
+        m_decodeDelay.packetSent(packet->pts, packetTimeUs, captureTimeUs);
+        return receiveGrayFrame(decodeTimer, captureTimeUs);
+    }
 
-                // 统计
-                totalReadTime += readTime;
-                totalDecodeTime += decodeTime;
-                totalConvertTime += convertTime;
-                frameCount++;
+    // 文件结束后取出解码器里剩余的帧（帧线程模式下最多 thread_count-1 帧），取完返回空
+    cv::Mat drainDecoder() {
+        if (!m_decoderDraining) {
+            avcodec_send_packet(m_codecContext, nullptr);
+            m_decoderDraining = true;
+        }
+        QElapsedTimer decodeTimer;
+        decodeTimer.start();
+        return receiveGrayFrame(decodeTimer, m_lastCaptureTimeUs);
+    }
 
-                // 每100帧输出详细统计
-                if (frameCount % 100 == 0) {
-                    double avgRead = totalReadTime / frameCount;
-                    double avgDecode = totalDecodeTime / frameCount;
-                    double avgConvert = totalConvertTime / frameCount;
-                    double cacheHitRate = (double)cacheHits / frameCount * 100;
+    // 解码器取空后标记流结束，采集循环据此停止
+    cv::Mat drainAtEndOfStream() {
+        cv::Mat rest = drainDecoder();
+        if (rest.empty()) {
+            m_endOfStream = true;
+        }
+        return rest;
+    }
 
-                    // 重置统计
-                    totalReadTime = 0;
-                    totalDecodeTime = 0;
-                    totalConvertTime = 0;
-                    frameCount = 0;
-                    cacheHits = 0;
-                }
+    // 从解码器取一帧并转为灰度图，没有可输出的帧时返回空；decodeTimer 从送包时开始计时
+    cv::Mat receiveGrayFrame(const QElapsedTimer& decodeTimer, int64_t captureTimeUs) {
+        QElapsedTimer convertTimer;
+        int ret = avcodec_receive_frame(m_codecContext, m_frame);
+        double decodeTime = decodeTimer.nsecsElapsed() / 1e6;
+        if (ret != 0 || m_frame->width <= 0 || m_frame->height <= 0) {
+            return cv::Mat();
+        }
 
-                cv::Mat result = grayFrame.clone();
-                av_packet_unref(m_packet);
+        // 数据包到达 → 帧输出：帧线程模式下包含在解码器中排队的帧数
+        int64_t frameOutUs = steadyNowUs();
+        int64_t frameCaptureUs = captureTimeUs;
+        int64_t delayUs = m_decodeDelay.frameReceived(m_frame->pts, frameOutUs, frameCaptureUs);
 
-                double totalTime = totalTimer.nsecsElapsed() / 1e6;
+        if (!m_profileConfirmed) {
+            confirmCaptureProfile();
+        }
 
-                return result;
-            }
-            else if(ret == AVERROR(EAGAIN)) {
-                av_packet_unref(m_packet);
-                continue;
+        convertTimer.start();
+        cv::Mat grayFrame;
+        if (isLumaPlaneFormat(m_frame) && lumaPlaneShareable(m_frame)) {
+            // 快速路径：Y 平面本身就是灰度图，直接引用解码帧，不做色彩转换也不拷贝
+            grayFrame = wrapLumaPlane(m_frame);
+        } else if (isLumaPlaneFormat(m_frame)) {
+            // 帧间编码的解码帧仍是后续帧的参考帧（帧线程解码器可能正在读），下游显示会在原图上画标记，
+            // 不能引用；只把当前区域的 Y 平面拷进缓冲池 slab，仍省去色彩转换
+            grayFrame = copyLumaRegion(m_frame);
+        } else if (m_swsContext) {
+            // 其他格式：转换到缓冲池取出的 slab，省去一次整帧 clone
+            grayFrame = m_framePool.acquire(m_codecContext->height, m_codecContext->width, CV_8UC1);
+            uint8_t* dstData[4] = { grayFrame.data, nullptr, nullptr, nullptr };
+            int dstLinesize[4] = { (int)grayFrame.step, 0, 0, 0 };
+            int scaleResult = sws_scale(m_swsContext,
+                                        (uint8_t const * const *)m_frame->data,
+                                        m_frame->linesize,
+                                        0,
+                                        m_codecContext->height,
+                                        dstData,
+                                        dstLinesize);
+            if (scaleResult <= 0) {
+                return cv::Mat();
             }
+        }
+        double convertTime = convertTimer.nsecsElapsed() / 1e6;
 
-            av_packet_unref(m_packet);
+        if (grayFrame.empty()) {
+            return cv::Mat();
         }
 
-        return cv::Mat();
+        if (m_decodeHist) {
+            m_decodeHist->recordMs(decodeTime);
+            m_convertHist->recordMs(convertTime);
+            if (delayUs >= 0) {
+                m_decodeDelayHist->recordNs(delayUs * 1000);
+            }
+        }
+        m_lastDecodeDelayUs = delayUs;
+
+        // FFmpeg 源没有驱动时间戳，以对应数据包到达的时刻近似（回放时为录制的时间戳）
+        m_lastCaptureTimeUs = frameCaptureUs;
+        m_lastSequence = -1;
+        m_lastPts = m_frame->best_effort_timestamp;
+        return grayFrame;
     }
 
 
     void cleanup(){
         QMutexLocker locker(&m_mutex);
+        stopPrefetchThread();
+        stopDemuxThread();
+        m_replay.close();
+        m_currentFrame.release();
+#ifdef HAVE_V4L2
+        m_v4l2.close();
+#endif
+        m_useV4l2 = false;
         if(m_swsContext){
             sws_freeContext(m_swsContext);
             m_swsContext = nullptr;
         }
-        if(m_buffer){
-            av_free(m_buffer);
-            m_buffer = nullptr;
-        }
-        if(m_frameRGB){
-            av_frame_free(&m_frameRGB);
-        }
         if(m_frame){
             av_frame_free(&m_frame);
         }
@@ -563,17 +1039,19 @@ public:
     }
 
     void pipe(QSemaphore & inSem, QSemaphore & outSem){
-        bool pauseLogShown = false;
-        while(m_paused && !exit() && !m_shouldClose) {
-            if (!pauseLogShown) {
-                qDebug() << "管道启动时即处于暂停状态，开始缓冲区管理...";
-                pauseLogShown = true;
-            }
+        m_captureRunning = true;
+        captureLoop(inSem, outSem);
+        m_captureRunning = false;
+        m_stateSignal.notifyAll();
+    }
 
-            // 即使在初始化之前也要尝试清理（如果摄像头已打开）
-            handlePauseBufferManagement();
-            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    void captureLoop(QSemaphore & inSem, QSemaphore & outSem){
+        bool pauseLogShown = m_paused;
+        if (pauseLogShown) {
+            qDebug() << "管道启动时即处于暂停状态，开始缓冲区管理...";
         }
+        // 即使在初始化之前也要尝试清理（如果摄像头已打开）
+        waitWhileCapturePaused();
 
         if (pauseLogShown) {
             qDebug() << "🔧 管道从暂停状态恢复，继续正常流程";
@@ -588,13 +1066,23 @@ public:
             return;
         }
 
-        static const cv::Rect roi(0, 0, 800, 720);
-        FrameImage* pOutFrame = (FrameImage*)m_pOutImage;
         int frameId = 0;
 
         // 区分摄像头和视频文件的帧率控制参数
         bool isVideoFile = (sourceType == 1);
         bool isCamera = (sourceType == 0);
+        bool isReplay = (sourceType == 2);
+        bool unthrottled = isUnthrottled();
+        m_replayBaseCaptureUs = -1;
+        m_gapDetector.reset();
+        m_autoCropRestart = true;
+
+        // 不限速模式的整体吞吐统计
+        QElapsedTimer runTimer;
+        runTimer.start();
+        int runFrames = 0;
+        int64_t firstCaptureUs = -1;
+        int64_t lastCaptureUs = -1;
 
         const int FILE_TARGET_FPS = 60;
         const double FILE_INTERVAL_MS = 1000.0 / FILE_TARGET_FPS;
@@ -614,10 +1102,33 @@ public:
         double totalProcessingTime = 0;
         double totalReadTime = 0;
         double totalWaitTime = 0;
+        double totalDecodeDelay = 0;
+        int delayFrameCount = 0;
         int statFrameCount = 0;
 
-        qDebug() << "开始处理" << (isVideoFile ? "视频文件" : "摄像头")
-                 << "目标帧率:" << (isVideoFile ? FILE_TARGET_FPS : TARGET_FPS) << "fps";
+        if (unthrottled) {
+            qDebug() << "开始处理" << (isReplay ? "数据包回放" : "视频文件") << "不限速";
+        } else {
+            qDebug() << "开始处理" << (isVideoFile ? "视频文件" : "摄像头")
+                     << "目标帧率:" << (isVideoFile ? FILE_TARGET_FPS : TARGET_FPS) << "fps";
+        }
+
+        // 性能指标：循环外注册，循环内只做无锁记录
+        bindMetrics();
+        LatencyHistogram& waitHist = stepHistogram("wait");
+        LatencyHistogram& processingHist = stepHistogram("processing");
+        LatencyHistogram& loopHist = stepHistogram("loop");
+        std::atomic<uint64_t>& frameCounter = stageCounter("frames");
+        std::atomic<uint64_t>& readFailCounter = stageCounter("readFailures");
+        std::atomic<uint64_t>& outDropCounter = stageCounter("outputDropped");
+        LatencyHistogram& intervalHist = stepHistogram("frameInterval");
+        std::atomic<uint64_t>& droppedCounter = stageCounter("droppedFrames");
+        std::atomic<uint64_t>& duplicateCounter = stageCounter("duplicateFrames");
+        LatencyHistogram& autoCropHist = stepHistogram("autoCrop");
+        std::atomic<uint64_t>& cropMoveCounter = stageCounter("cropMoves");
+        uint64_t statDropped = 0;
+        uint64_t statDuplicates = 0;
+        LatencyHistogram& archiveHist = stepHistogram("archiveWrite");
 
         while (!exit() && !m_shouldClose) {
             QElapsedTimer completeLoopTimer;
@@ -628,18 +1139,9 @@ public:
             double waitTimeMs = 0;
 
             if(m_isopened && !m_shouldClose){
-                // 暂停处理逻辑
-                bool wasPaused = false;
-                while(m_paused && !exit() && !m_shouldClose) {
-                    if (!wasPaused) {
-                        wasPaused = true;
-                    }
-
-                    // 暂停期间积极清理缓冲区
-                    handlePauseBufferManagement();
-
-                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
-                }
+                // 暂停处理逻辑：阻塞到恢复/退出/关闭，摄像头在此期间持续清理缓冲区
+                bool wasPaused = m_paused;
+                waitWhileCapturePaused();
                 if (wasPaused) {
                     // 重置时间控制和统计数据
                     if (isVideoFile) {
@@ -648,6 +1150,8 @@ public:
                     } else {
                         startTime = std::chrono::high_resolution_clock::now();
                     }
+                    m_replayBaseCaptureUs = -1;
+                    m_gapDetector.reset();
                     totalFrames = 0;
                     successfulFrames = 0;
                     consecutiveFailures = 0;
@@ -656,6 +1160,8 @@ public:
                     totalProcessingTime = 0;
                     totalReadTime = 0;
                     totalWaitTime = 0;
+                    totalDecodeDelay = 0;
+                    delayFrameCount = 0;
                     statFrameCount = 0;
                 }
 
@@ -665,7 +1171,7 @@ public:
                 QElapsedTimer waitTimer;
                 waitTimer.start();
 
-                if (isVideoFile) {
+                if (isVideoFile && !unthrottled) {
                     if (!isFirstFrame) {
                         auto currentTime = std::chrono::high_resolution_clock::now();
                         auto timeSinceLastFrame = std::chrono::duration_cast<std::chrono::microseconds>(
@@ -674,7 +1180,7 @@ public:
                         double elapsedMs = timeSinceLastFrame.count() / 1000.0;
                         if (elapsedMs < FILE_INTERVAL_MS) {
                             waitTimeMs = FILE_INTERVAL_MS - elapsedMs;
-                            std::this_thread::sleep_for(std::chrono::microseconds((int)(waitTimeMs * 1000)));
+                            waitInterruptible(std::chrono::microseconds((int)(waitTimeMs * 1000)));
                         }
                     } else {
                         isFirstFrame = false;
@@ -689,13 +1195,15 @@ public:
                     if (totalFrames >= expectedFrames) {
                         waitTimeMs = TARGET_INTERVAL_MS - (elapsed.count() / 1000.0 - expectedFrames * TARGET_INTERVAL_MS);
                         if (waitTimeMs > 0) {
-                            std::this_thread::sleep_for(std::chrono::microseconds((int)(waitTimeMs * 1000)));
+                            waitInterruptible(std::chrono::microseconds((int)(waitTimeMs * 1000)));
                         }
                     }
                 }
 
                 double actualWaitTime = waitTimer.nsecsElapsed() / 1e6;
                 totalWaitTime += actualWaitTime;
+                waitHist.recordMs(actualWaitTime);
+                if (stopRequested()) break;
 
                 // 开始实际处理计时
                 processingTimer.start();
@@ -711,7 +1219,11 @@ public:
                 totalFrames++;
 
                 if(src.empty()){
+                    if (m_endOfStream) {
+                        break;
+                    }
                     consecutiveFailures++;
+                    readFailCounter.fetch_add(1, std::memory_order_relaxed);
 
                     if (isVideoFile) {
                         qDebug() << "视频文件结束，重新开始播放";
@@ -724,7 +1236,10 @@ public:
                     if (consecutiveFailures >= maxFailures) {
                         qDebug() << "连续失败过多，重新初始化";
                         cleanup();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+                        // 给设备恢复留出时间，关闭/退出时立即返回
+                        if (waitInterruptible(std::chrono::milliseconds(1000))) {
+                            break;
+                        }
 
                         if (!initializeFFmpeg()) {
                             qDebug() << "重新初始化失败，退出";
@@ -734,6 +1249,7 @@ public:
                         consecutiveFailures = 0;
                         totalFrames = 0;
                         successfulFrames = 0;
+                        m_gapDetector.reset();
 
                         if (isCamera) {
                             startTime = std::chrono::high_resolution_clock::now();
@@ -744,7 +1260,7 @@ public:
                         continue;
                     }
 
-                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                    waitInterruptible(std::chrono::microseconds(500));
                     continue;
                 }
 
@@ -752,20 +1268,75 @@ public:
                 consecutiveFailures = 0;
                 successfulFrames++;
 
+                // 回放按录制时的帧间隔送出，等待时间不计入处理时间
+                double replayPaceMs = 0;
+                if (isReplay && !unthrottled) {
+                    QElapsedTimer paceTimer;
+                    paceTimer.start();
+                    paceReplay(m_output.captureTimeUs);
+                    replayPaceMs = paceTimer.nsecsElapsed() / 1e6;
+                    totalWaitTime += replayPaceMs;
+                    waitHist.recordMs(replayPaceMs);
+                }
+
                 frameId = SharedPipelineData::generateFrameId();
 
-                // ROI处理
-                cv::Mat roiFrame;
-                // if(src.cols > roi.x + roi.width && src.rows > roi.y + roi.height){
-                    roiFrame = src(roi);
-                // } else {
-                //     qDebug()<<"输出原图";
-                //     roiFrame = src;
-                // }
+                // 丢帧/重复帧检测：普通视频文件没有采集时间，只记录间隔不做判断
+                FrameTiming timing;
+                if (isVideoFile) {
+                    timing.captureTimeUs = m_output.captureTimeUs;
+                } else {
+                    timing = m_gapDetector.update(m_output.captureTimeUs, m_output.sequence);
+                    if (timing.droppedBefore > 0) {
+                        droppedCounter.fetch_add(timing.droppedBefore, std::memory_order_relaxed);
+                        statDropped += timing.droppedBefore;
+                    }
+                    if (timing.duplicate) {
+                        duplicateCounter.fetch_add(1, std::memory_order_relaxed);
+                        statDuplicates++;
+                    }
+                    if (timing.intervalUs > 0) {
+                        intervalHist.recordNs(timing.intervalUs * 1000);
+                    }
+                }
+
+                // ROI处理：只取视图，不拷贝；画面比 ROI 小时裁到画面范围内；
+                // 区域解码、V4L2 裁剪拷贝出来的帧只覆盖 m_output.region，在其中再取当前区域
+                if (m_autoCropRestart.exchange(false)) {
+                    restartAutoCrop();
+                }
+                cv::Point cropOrigin;
+                cv::Mat roiFrame = cropToCurrentRegion(src, cropOrigin);
+
+                if (m_cropEstimator.state() != EyeCropEstimator::CROP_IDLE_E) {
+                    QElapsedTimer cropTimer;
+                    cropTimer.start();
+                    if (m_cropEstimator.update(roiFrame, cropOrigin, m_output.scaleDenom)) {
+                        requestDecodeCrop(m_cropEstimator.crop());
+                        cropMoveCounter.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    autoCropHist.recordMs(cropTimer.nsecsElapsed() / 1e6);
+                }
 
                 SharedPipelineData::createFrameData(frameId, roiFrame);
-                pOutFrame->image = roiFrame.clone();
-                pOutFrame->frameId = frameId;
+
+                // 自动裁剪的启动阶段区域尚未确定，不写归档，保证归档内帧尺寸一致
+                if (m_archiveRequested && !m_cropEstimator.isWarmingUp()) {
+                    QElapsedTimer archiveTimer;
+                    archiveTimer.start();
+                    writeArchiveFrame(roiFrame);
+                    archiveHist.recordMs(archiveTimer.nsecsElapsed() / 1e6);
+                }
+
+                // readFrame 每次返回独立的缓冲区，ROI 视图直接移交给下一级，无需再 clone
+                PipeFrame outFrame;
+                outFrame.frameId = frameId;
+                outFrame.image = roiFrame;
+                outFrame.captureTimeUs = m_output.captureTimeUs;
+                outFrame.sequence = m_output.sequence;
+                outFrame.intervalUs = timing.intervalUs;
+                outFrame.droppedBefore = timing.droppedBefore;
+                outFrame.cropOrigin = cropOrigin;
 
                 // 更新时间记录
                 if (isVideoFile) {
@@ -773,9 +1344,13 @@ public:
                 }
 
                 // 计算实际处理时间（不包括等待）
-                double actualProcessingTime = processingTimer.nsecsElapsed() / 1e6;
+                double actualProcessingTime = processingTimer.nsecsElapsed() / 1e6 - replayPaceMs;
                 totalProcessingTime += actualProcessingTime;
                 statFrameCount++;
+                if (!m_useV4l2 && m_output.decodeDelayUs >= 0) {
+                    totalDecodeDelay += m_output.decodeDelayUs / 1000.0;
+                    delayFrameCount++;
+                }
 
                 // 完整循环时间
                 double completeMs = completeLoopTimer.nsecsElapsed() / 1e6;
@@ -791,34 +1366,74 @@ public:
                     qDebug() << QString("  - 平均读取时间: %1 ms").arg(avgReadTime, 0, 'f', 2);
                     qDebug() << QString("  - 平均处理时间: %1 ms (不含等待)").arg(avgProcessingTime, 0, 'f', 2);
                     qDebug() << QString("  - 平均等待时间: %1 ms").arg(avgWaitTime, 0, 'f', 2);
+                    if (delayFrameCount > 0) {
+                        qDebug() << QString("  - 平均解码延迟: %1 ms (%2)")
+                                    .arg(totalDecodeDelay / delayFrameCount, 0, 'f', 2)
+                                    .arg(m_useJpegRoiDecoder ? "turbojpeg" : decodeModeName(m_decodeMode));
+                    }
                     qDebug() << QString("  - 平均总循环时间: %1 ms").arg(avgCompleteTime, 0, 'f', 2);
                     qDebug() << QString("  - 实际处理FPS: %1").arg(1000.0 / avgProcessingTime, 0, 'f', 1);
                     qDebug() << QString("  - 输出FPS: %1").arg(1000.0 / avgCompleteTime, 0, 'f', 1);
                     qDebug() << QString("  - 成功率: %1%").arg((double)successfulFrames/totalFrames*100, 0, 'f', 1);
+                    if (!isVideoFile) {
+                        qDebug() << QString("  - 丢帧: %1 帧, 重复帧: %2 (标称间隔 %3 ms)")
+                                    .arg(statDropped).arg(statDuplicates)
+                                    .arg(m_gapDetector.nominalIntervalUs() / 1000.0, 0, 'f', 2);
+                    }
+                    statDropped = 0;
+                    statDuplicates = 0;
 
                     // 重置统计
                     totalProcessingTime = 0;
                     totalReadTime = 0;
                     totalWaitTime = 0;
+                    totalDecodeDelay = 0;
+                    delayFrameCount = 0;
                     statFrameCount = 0;
                 }
 
                 // 保存实际处理时间（不包括等待）到SharedPipelineData
                 SharedPipelineData::setTime(frameId, 1, actualProcessingTime);
+                processingHist.recordMs(actualProcessingTime);
+                loopHist.recordMs(completeMs);
+                frameCounter.fetch_add(1, std::memory_order_relaxed);
 
-                outSem.release();
+                if (firstCaptureUs < 0) {
+                    firstCaptureUs = m_output.captureTimeUs;
+                }
+                lastCaptureUs = m_output.captureTimeUs;
+                runFrames++;
+
+                // 下游来不及处理时直接丢弃本帧，采集不被处理阻塞；
+                // 不限速模式改为等待下游，由最慢的一级决定节奏且不丢帧
+                if (unthrottled) {
+                    if (!pushOutFrameWait(std::move(outFrame), outSem)) {
+                        break;
+                    }
+                } else if (!pushOutFrame(std::move(outFrame), outSem)) {
+                    outDropCounter.fetch_add(1, std::memory_order_relaxed);
+                }
                 sendOverSign(frameId);
 
             } else {
                 if (m_shouldClose) break;
                 qDebug() << "视频源未打开";
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                // 等待 reopenCamera/initializeFFmpeg 重新打开，或退出/关闭
+                m_stateSignal.wait([this]() { return m_isopened || stopRequested(); });
             }
         }
 
+        if (unthrottled && m_endOfStream) {
+            reportRunSummary(runFrames, runTimer.nsecsElapsed() / 1e9, firstCaptureUs, lastCaptureUs);
+        }
+
         if (!m_shouldClose) {
             resetSource();
         }
+
+        if (unthrottled && m_endOfStream) {
+            emit replayFinished();
+        }
     }
 
     void forceCloseCamera() {
@@ -827,22 +1442,27 @@ public:
         m_shouldClose = true;
         m_isopened = false;
 
-        // 不等待，直接清理
+        m_stateSignal.notifyAll();
+#ifdef HAVE_V4L2
+        m_v4l2.wakeup();
+#endif
+
+        // 不等待，直接清理（cleanup 持锁，会等正在进行的 readFrame 返回）
         cleanup();
 
-// Windows下等待更长时间
-#ifdef _WIN32
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-#endif
+        // 等采集线程退出后再清除关闭标志，代替固定等待
+        waitForCaptureStopped();
 
         m_shouldClose = false;
         qDebug() << "强制关闭完成";
     }
 signals:
     void sendOverSign(int frameId);
+    // 不限速模式下文件/回放处理完毕，采集线程已退出
+    void replayFinished();
 
 private:
-    int sourceType;  // 0: 摄像头 1:文件
+    int sourceType;  // 0: 摄像头 1:文件 2:数据包回放
     int cameraIndex; // 摄像头索引
     std::string filePath; // 选到的文件
     QVariant m_source;
@@ -851,6 +1471,7 @@ private:
     int m_width;  // 分辨率宽度
     int m_height; // 分辨率高度
     double m_fps; // 帧率
+    cv::Rect m_captureRoi{0, 0, 800, 720};  // 眼部区域
 
     // 帧同步相关
     cv::Mat m_currentFrame;
@@ -863,11 +1484,114 @@ private:
     int m_videoStreamIndex;
     AVCodec *m_codec;
     AVFrame *m_frame;
-    AVFrame *m_frameRGB;
     AVPacket *m_packet;
     SwsContext *m_swsContext;
-    uint8_t *m_buffer;
-    bool m_isopened;
+    FrameBufferPool m_framePool;   // readFrame 输出缓冲池
+
+#ifdef HAVE_V4L2
+    V4l2Capture m_v4l2;            // Linux 原生采集，打开成功时替代 FFmpeg
+#endif
+    std::atomic<bool> m_useV4l2{false};
+#ifdef HAVE_LIBJPEG_TURBO
+    JpegRoiDecoder m_jpegDecoder;      // MJPEG 眼部区域解码
+#endif
+    bool m_useJpegRoiDecoder = false;
+    bool m_v4l2ZeroCopy = false;       // V4L2 GREY 零拷贝，默认拷贝到缓冲池
+    int m_jpegScaleDenom = 1;
+    // 解码侧最近一帧的信息，预解码时由预解码线程写入
+    bool m_frameCropped = false;       // 最近一帧已是 ROI，无需再裁剪
+    cv::Rect m_frameRegion;            // 已裁剪时该帧覆盖的原始画面区域
+    int m_frameScaleDenom = 1;
+    cv::Rect m_lumaCopyCrop;           // 拷贝 Y 平面时使用的区域，只在解码所在线程访问
+    int64_t m_lastCaptureTimeUs = 0;   // 最近一帧的采集时间戳（steady_clock 基准，微秒）
+    int64_t m_lastSequence = -1;       // 最近一帧的驱动帧序号，FFmpeg 源为 -1
+    int64_t m_lastPts = AV_NOPTS_VALUE;
+    // 采集循环当前处理的帧的信息（image 不保留），由 readFrame 写入
+    DecodedFrame m_output;
+
+    // 文件预解码线程：解码好的帧排队，采集线程只取帧
+    bool m_prefetchEnabled = false;
+    size_t m_prefetchDepth = 8;
+    std::thread m_prefetchThread;
+    std::mutex m_prefetchMutex;
+    std::condition_variable m_prefetchCond;
+    std::deque<DecodedFrame> m_prefetchQueue;
+    std::atomic<bool> m_prefetchStop{false};
+    std::atomic<uint64_t>* m_prefetchEmptyCounter = nullptr;
+
+    // readFrame 内部子步骤的性能指标，由 bindMetrics() 绑定
+    LatencyHistogram* m_readHist = nullptr;
+    LatencyHistogram* m_decodeHist = nullptr;
+    LatencyHistogram* m_convertHist = nullptr;
+    LatencyHistogram* m_readFrameHist = nullptr;
+    std::atomic<uint64_t>* m_cacheHitCounter = nullptr;
+    LatencyHistogram* m_decodeDelayHist = nullptr;
+    std::atomic<uint64_t>* m_demuxDropCounter = nullptr;
+
+    // 解码线程模式与延迟统计
+    DECODE_MODE_E m_decodeMode = DECODE_FRAME_THREADS_E;
+    int m_decodeThreadCount = 4;
+    DecodeDelayTracker m_decodeDelay;
+    int64_t m_lastDecodeDelayUs = -1;
+
+    // 不限速模式：文件读完后排空解码器，取空即结束
+    REPLAY_PACE_E m_replayPace = REPLAY_REALTIME_E;
+    bool m_decoderDraining = false;
+    std::atomic<bool> m_endOfStream{false};
+
+    // 解复用线程（DECODE_DEMUX_THREAD_E）：读包入队，采集线程取包解码
+    struct DemuxedPacket {
+        AVPacket* packet;   // nullptr 表示文件已回到开头，解码器需要刷新
+        int64_t timeUs;     // 数据包到达时刻
+        bool endOfStream;   // 不限速模式下文件结束，packet 为 nullptr
+    };
+    static const size_t DEMUX_QUEUE_DEPTH = 2;
+    std::thread m_demuxThread;
+    std::mutex m_demuxMutex;
+    std::condition_variable m_demuxCond;
+    std::deque<DemuxedPacket> m_demuxQueue;
+    std::atomic<bool> m_demuxStop{false};
+
+    // 原始数据包录制与回放
+    PacketRecorder m_recorder;
+    QString m_recordPath;              // 非空表示请求录制
+    PacketReader m_replay;
+    int64_t m_replayBaseCaptureUs = -1;
+    int64_t m_replayBaseWallUs = 0;
+
+    // 摄像头采集参数缓存：m_profileKey 为空表示当前源不使用缓存
+    QString m_profileKey;
+    CaptureProfile m_profile;           // 本次打开所用的缓存参数
+    bool m_profileFromCache = false;
+    bool m_profileConfirmed = false;    // 已解出第一帧
+    int m_swsWidth = 0;
+    int m_swsHeight = 0;
+    AVPixelFormat m_swsFormat = AV_PIX_FMT_NONE;
+
+    // 采集端丢帧/重复帧检测
+    FrameGapDetector m_gapDetector;
+
+    // 自动裁剪：估计器只在采集线程中使用；解码侧的裁剪区域经 m_cropMutex 交给解码所在线程
+    EyeCropEstimator m_cropEstimator;
+    std::atomic<bool> m_autoCropEnabled{false};
+    std::atomic<bool> m_autoCropRestart{false};
+    int m_autoCropWarmup = 30;
+    int m_autoCropMargin = 300;
+    std::mutex m_cropMutex;
+    cv::Rect m_decodeCrop;             // 请求解码侧使用的区域
+    bool m_decodeCropChanged = false;
+    cv::Rect m_activeCrop;             // 最近一帧实际送出的区域
+
+    // 预处理帧归档
+    FrameArchiveWriter m_archiveWriter;
+    QString m_archivePath;
+    std::mutex m_archiveMutex;
+    std::atomic<bool> m_archiveRequested{false};
+    std::atomic<bool> m_isopened;
+    std::atomic<bool> m_captureRunning{false};  // 采集线程是否在 pipe() 中
+    int m_pauseDrainCount = 0;
+    bool m_resumeFlushPending = false;  // 暂停期间丢过数据包，恢复时需刷新解码器
+    bool m_awaitKeyframe = false;       // 恢复后丢弃到下一个关键帧
 
     // 线程安全
     mutable  QMutex m_mutex;
@@ -876,32 +1600,681 @@ private:
     QElapsedTimer m_performanceTimer;
 
 
-    void handlePauseBufferManagement(){
-        static int clearCount = 0;
-        static auto lastClearTime = std::chrono::high_resolution_clock::now();
-
-        auto now = std::chrono::high_resolution_clock::now();
-        auto timeSinceLastClear = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastClearTime);
-
-        // 每25ms清理一次缓冲区，比较频繁
-        if (timeSinceLastClear.count() >= 25) {
-            if (m_isopened && m_formatContext) {
-                // 🔧 关键：连续读取多帧快速清空缓冲区
-                for (int i = 0; i < 5; ++i) {  // 一次读取最多5帧
-                    cv::Mat discardFrame = readFrame();
-                    if (discardFrame.empty()) {
-                        break; // 缓冲区已空，退出循环
-                    }
-                    // 立即丢弃帧，不做任何处理
+    // 退出或关闭请求
+    bool stopRequested() const {
+        return exit() || m_shouldClose;
+    }
+
+    // 可被退出/关闭立即打断的等待，替代固定 sleep；返回 true 表示被打断
+    template <typename Rep, typename Period>
+    bool waitInterruptible(const std::chrono::duration<Rep, Period>& duration) {
+        return m_stateSignal.waitFor([this]() { return stopRequested(); }, duration);
+    }
+
+    // FFmpeg 阻塞调用（打开设备、读包）期间轮询，返回非 0 时立即中止
+    static int interruptCallback(void* opaque) {
+        videoCapturePip* self = static_cast<videoCapturePip*>(opaque);
+        return (self->stopRequested() || self->m_demuxStop || self->m_prefetchStop) ? 1 : 0;
+    }
+
+    void startPrefetchThread() {
+        m_prefetchStop = false;
+        m_prefetchThread = std::thread(&videoCapturePip::prefetchLoop, this);
+        qDebug() << "文件预解码已启动，队列深度" << (int)m_prefetchDepth;
+    }
+
+    // 调用前需保证解码器仍然有效；阻塞中的读包由中断回调打断
+    void stopPrefetchThread() {
+        if (!m_prefetchThread.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_prefetchMutex);
+            m_prefetchStop = true;
+        }
+        m_prefetchCond.notify_all();
+        m_prefetchThread.join();
+
+        std::lock_guard<std::mutex> lock(m_prefetchMutex);
+        m_prefetchQueue.clear();
+        m_prefetchStop = false;
+    }
+
+    // 预解码线程独占解码器和读包（含文件结束时的定位/回到开头），结果按顺序排队
+    void prefetchLoop() {
+        while (!m_prefetchStop && !stopRequested()) {
+            DecodedFrame decoded = decodeNextFrame();
+            if (decoded.image.empty()) {
+                if (m_endOfStream) {
+                    decoded.endOfStream = true;
+                } else {
+                    waitInterruptible(std::chrono::milliseconds(1));
+                    continue;
                 }
+            }
+
+            std::unique_lock<std::mutex> lock(m_prefetchMutex);
+            m_prefetchCond.wait(lock, [this]() {
+                return m_prefetchQueue.size() < m_prefetchDepth || m_prefetchStop;
+            });
+            if (m_prefetchStop) {
+                break;
+            }
+            bool endOfStream = decoded.endOfStream;
+            m_prefetchQueue.push_back(std::move(decoded));
+            lock.unlock();
+            m_prefetchCond.notify_all();
+            if (endOfStream) {
+                break;
+            }
+        }
+    }
+
+    // 在采集线程中调用：等到有现成的帧；遇到结束标记时保留标记并返回空，关闭/退出时返回空
+    cv::Mat popPrefetchedFrame() {
+        std::unique_lock<std::mutex> lock(m_prefetchMutex);
+        if (m_prefetchQueue.empty() && m_prefetchEmptyCounter) {
+            m_prefetchEmptyCounter->fetch_add(1, std::memory_order_relaxed);
+        }
+        while (m_prefetchQueue.empty()) {
+            if (stopRequested() || m_prefetchStop) {
+                return cv::Mat();
+            }
+            m_prefetchCond.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        if (m_prefetchQueue.front().endOfStream) {
+            return cv::Mat();
+        }
+        DecodedFrame decoded = std::move(m_prefetchQueue.front());
+        m_prefetchQueue.pop_front();
+        lock.unlock();
+        m_prefetchCond.notify_all();
+
+        cv::Mat image = decoded.image;
+        decoded.image.release();
+        // 普通视频文件没有采集时间，以交给管道的时刻为准，排队等待不计入下游延迟
+        if (sourceType == 1) {
+            decoded.captureTimeUs = steadyNowUs();
+        }
+        m_output = decoded;
+        return image;
+    }
 
-                clearCount++;
-                // 每隔一段时间输出一次调试信息，避免日志刷屏
-                if (clearCount % 40 == 0) {
-                    qDebug() << "🔧 缓冲区清理进行中... 已清理" << clearCount << "次";
+    void startDemuxThread() {
+        m_demuxStop = false;
+        m_demuxThread = std::thread(&videoCapturePip::demuxLoop, this);
+    }
+
+    // 调用前需保证格式上下文仍然有效；阻塞中的 av_read_frame 由中断回调打断
+    void stopDemuxThread() {
+        if (!m_demuxThread.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_demuxMutex);
+            m_demuxStop = true;
+        }
+        m_demuxCond.notify_all();
+        m_demuxThread.join();
+
+        std::lock_guard<std::mutex> lock(m_demuxMutex);
+        for (DemuxedPacket& item : m_demuxQueue) {
+            av_packet_free(&item.packet);
+        }
+        m_demuxQueue.clear();
+        m_demuxStop = false;
+    }
+
+    void demuxLoop() {
+        AVPacket* packet = av_packet_alloc();
+        while (packet && !m_demuxStop && !stopRequested()) {
+            int ret = av_read_frame(m_formatContext, packet);
+            int64_t timeUs = steadyNowUs();
+
+            if (ret == AVERROR_EOF && sourceType == 1 && isUnthrottled()) {
+                pushDemuxedPacket(nullptr, timeUs, true);
+                break;
+            }
+            if (ret == AVERROR_EOF && sourceType == 1) {
+                qDebug() << "视频文件结束，重新开始播放";
+                if (avformat_seek_file(m_formatContext, -1, INT64_MIN, 0, INT64_MAX, AVSEEK_FLAG_BACKWARD) < 0) {
+                    qDebug() << "视频文件定位失败，解复用线程退出";
+                    break;
+                }
+                pushDemuxedPacket(nullptr, timeUs);
+                continue;
+            }
+            if (ret < 0) {
+                // 暂时无数据或读取出错：稍后重试，持续失败时由采集线程的失败计数触发重新初始化
+                std::unique_lock<std::mutex> lock(m_demuxMutex);
+                m_demuxCond.wait_for(lock, std::chrono::milliseconds(ret == AVERROR(EAGAIN) ? 1 : 10),
+                                     [this]() { return m_demuxStop.load(); });
+                continue;
+            }
+            if (packet->stream_index != m_videoStreamIndex) {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            AVPacket* queued = av_packet_alloc();
+            if (!queued) {
+                av_packet_unref(packet);
+                continue;
+            }
+            av_packet_move_ref(queued, packet);
+            pushDemuxedPacket(queued, timeUs);
+        }
+        av_packet_free(&packet);
+    }
+
+    // 摄像头：队列满时丢弃最旧的包（MJPEG 帧间无依赖），保证解码的总是最新帧；
+    // 文件：等待解码侧取走，保持原有的读取节奏
+    void pushDemuxedPacket(AVPacket* packet, int64_t timeUs, bool endOfStream = false) {
+        std::unique_lock<std::mutex> lock(m_demuxMutex);
+        if (sourceType == 1) {
+            m_demuxCond.wait(lock, [this]() {
+                return m_demuxQueue.size() < DEMUX_QUEUE_DEPTH || m_demuxStop;
+            });
+        } else {
+            while (m_demuxQueue.size() >= DEMUX_QUEUE_DEPTH) {
+                av_packet_free(&m_demuxQueue.front().packet);
+                m_demuxQueue.pop_front();
+                if (m_demuxDropCounter) {
+                    m_demuxDropCounter->fetch_add(1, std::memory_order_relaxed);
                 }
             }
-            lastClearTime = now;
+        }
+        if (m_demuxStop) {
+            av_packet_free(&packet);
+            return;
+        }
+        m_demuxQueue.push_back({ packet, timeUs, endOfStream });
+        lock.unlock();
+        m_demuxCond.notify_all();
+    }
+
+    // 在采集线程中调用；短时间内没有数据包时返回 EAGAIN，让上层检查关闭/退出
+    int popDemuxedPacket(AVPacket* packet, int64_t& packetTimeUs) {
+        std::unique_lock<std::mutex> lock(m_demuxMutex);
+        m_demuxCond.wait_for(lock, std::chrono::milliseconds(50), [this]() {
+            return !m_demuxQueue.empty() || m_demuxStop;
+        });
+        if (m_demuxQueue.empty()) {
+            return AVERROR(EAGAIN);
+        }
+        DemuxedPacket item = m_demuxQueue.front();
+        m_demuxQueue.pop_front();
+        lock.unlock();
+        m_demuxCond.notify_all();
+
+        if (item.endOfStream) {
+            return AVERROR_EOF;
+        }
+        if (!item.packet) {
+            avcodec_flush_buffers(m_codecContext);
+            m_decodeDelay.clear();
+            return AVERROR(EAGAIN);
+        }
+        av_packet_move_ref(packet, item.packet);
+        av_packet_free(&item.packet);
+        packetTimeUs = item.timeUs;
+        return 0;
+    }
+
+    // 暂停时阻塞到恢复/退出/关闭。文件源直接等待通知；
+    // 摄像头源需持续取走设备缓冲的帧，读取本身按设备帧率阻塞，无需额外 sleep
+    void waitWhileCapturePaused() {
+        while (m_paused && !stopRequested()) {
+            if (sourceType == 0 && m_isopened && (m_formatContext || m_useV4l2)) {
+                handlePauseBufferManagement();
+            } else {
+                m_stateSignal.wait([this]() { return !m_paused || stopRequested(); });
+            }
+        }
+    }
+
+    // 8 位平面 YUV（含 JPEG 全范围变体）、NV12/NV21 和 GRAY8 的第一个平面就是亮度。
+    // 原转换也按全范围处理，Y 值原样输出，因此直接取 Y 平面结果一致
+    static bool isLumaPlaneFormat(const AVFrame* frame) {
+        if (!frame->data[0] || frame->linesize[0] <= 0) {
+            return false;
+        }
+        switch (frame->format) {
+        case AV_PIX_FMT_YUVJ420P:
+        case AV_PIX_FMT_YUVJ422P:
+        case AV_PIX_FMT_YUVJ440P:
+        case AV_PIX_FMT_YUVJ444P:
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUV422P:
+        case AV_PIX_FMT_YUV440P:
+        case AV_PIX_FMT_YUV444P:
+        case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_NV21:
+        case AV_PIX_FMT_GRAY8:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // 解码帧可以交给下游直接引用：帧内编码（MJPEG）的帧不会被后续帧参考，
+    // 或者解码器已不再持有该缓冲区
+    bool lumaPlaneShareable(const AVFrame* frame) const {
+        const AVCodecDescriptor* descriptor = avcodec_descriptor_get(m_codecContext->codec_id);
+        return (descriptor && (descriptor->props & AV_CODEC_PROP_INTRA_ONLY)) || av_frame_is_writable(frame);
+    }
+
+    // 把 Y 平面中当前区域（解码侧的裁剪区域，未设置时为 setCaptureRoi 的区域）拷进缓冲池 slab；
+    // 只拷了部分画面时按区域解码的方式记录该帧覆盖的区域
+    cv::Mat copyLumaRegion(const AVFrame* frame) {
+        cv::Rect full(0, 0, frame->width, frame->height);
+        cv::Rect region = (m_lumaCopyCrop.area() > 0 ? m_lumaCopyCrop : m_captureRoi) & full;
+        if (region.area() <= 0) {
+            region = full;
+        }
+        cv::Mat luma(frame->height, frame->width, CV_8UC1, frame->data[0], frame->linesize[0]);
+        cv::Mat gray = m_framePool.acquire(region.height, region.width, CV_8UC1);
+        luma(region).copyTo(gray);
+        if (region != full) {
+            m_frameCropped = true;
+            m_frameRegion = region;
+            m_frameScaleDenom = 1;
+        }
+        return gray;
+    }
+
+    // 引用解码帧（只增加缓冲区引用计数），Mat 的最后一个持有者释放时归还给解码器
+    static cv::Mat wrapLumaPlane(const AVFrame* frame) {
+        AVFrame* ref = av_frame_clone(frame);
+        if (!ref) {
+            return cv::Mat();
+        }
+        return ForeignMatAllocator::wrap(ref->height, ref->width, CV_8UC1,
+                                         ref->data[0], ref->linesize[0],
+                                         [ref]() mutable { av_frame_free(&ref); });
+    }
+
+    static int64_t steadyNowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+#ifdef HAVE_V4L2
+    // 解析设备并以 m_width/m_height/m_fps 打开，驱动缓冲区多留几个给零拷贝帧
+    bool openV4l2Camera() {
+        std::string device = V4l2Capture::findDevice(m_source.toString().toStdString());
+        if (device.empty()) {
+            qDebug() << "未找到 V4L2 设备" << m_source.toString();
+            return false;
+        }
+#ifdef HAVE_LIBJPEG_TURBO
+        m_v4l2.setJpegDecoder(m_useJpegRoiDecoder ? &m_jpegDecoder : nullptr);
+#endif
+        // 需要拷贝的格式只拷贝眼部区域，自动裁剪确定区域后再收窄
+        m_v4l2.setCrop(m_captureRoi);
+        m_v4l2.setZeroCopy(m_v4l2ZeroCopy);
+        // MJPEG 数据包在归还驱动前交给录制（未录制时 write 直接返回）
+        m_v4l2.setPayloadTap([this](const uint8_t* data, size_t size, int64_t timestampUs) {
+            m_recorder.write(data, size, timestampUs);
+        });
+
+        // 缓存的格式直接协商，省去逐个格式尝试；打不开或帧率达不到缓存值时回退到自动协商
+        std::string identity = V4l2Capture::deviceIdentity(device);
+        QString profileKey = CaptureProfileCache::makeKey("v4l2", QString::fromStdString(identity.empty() ? device : identity),
+                                                          m_width, m_height, m_fps);
+        CaptureProfile cached;
+        bool fromCache = CaptureProfileCache::load(profileKey, cached);
+        bool opened = false;
+        if (fromCache) {
+            opened = m_v4l2.open(device, m_width, m_height, m_fps, (V4l2Capture::PixelFormat)cached.pixelFormat, 6)
+                     && m_v4l2.width() == cached.width && m_v4l2.height() == cached.height
+                     && m_v4l2.fps() + 0.5 >= cached.fps;
+            if (!opened) {
+                qDebug() << "缓存的 V4L2 采集参数已失效，重新协商";
+                m_v4l2.close();
+                CaptureProfileCache::remove(profileKey);
+                fromCache = false;
+            }
+        }
+        if (!opened && !m_v4l2.open(device, m_width, m_height, m_fps, V4l2Capture::FORMAT_AUTO, 6)) {
+            return false;
+        }
+
+        if (!fromCache) {
+            CaptureProfile profile;
+            profile.pixelFormat = m_v4l2.format();
+            profile.width = m_v4l2.width();
+            profile.height = m_v4l2.height();
+            profile.fps = m_v4l2.fps();
+            CaptureProfileCache::store(profileKey, profile);
+        }
+        m_useV4l2 = true;
+        return true;
+    }
+
+    // 按设备帧率阻塞取帧，关闭/退出时由 wakeup() 打断
+    cv::Mat readV4l2Frame() {
+        QElapsedTimer readTimer;
+        readTimer.start();
+
+        V4l2Capture::Frame frame;
+        if (!m_v4l2.read(frame, 1000)) {
+            return cv::Mat();
+        }
+        m_lastCaptureTimeUs = frame.timestampUs;
+        m_lastSequence = frame.sequence;
+        m_lastPts = AV_NOPTS_VALUE;
+        m_frameCropped = frame.cropped;
+        m_frameRegion = frame.region;
+        m_frameScaleDenom = frame.scaleDenom;
+
+        if (m_readFrameHist) {
+            m_readFrameHist->recordMs(readTimer.nsecsElapsed() / 1e6);
+        }
+        return frame.image;
+    }
+#endif
+
+    // 按当前源的编解码参数开始录制；未请求录制或已在录制时直接返回。调用方持有 m_mutex
+    void openRecorderForCurrentSource() {
+        if (m_recordPath.isEmpty() || m_recorder.isOpen()) {
+            return;
+        }
+#ifdef HAVE_V4L2
+        if (m_useV4l2) {
+            if (m_v4l2.format() != V4l2Capture::FORMAT_MJPEG) {
+                qDebug() << "V4L2" << V4l2Capture::formatName(m_v4l2.format()) << "不是压缩格式，不录制数据包";
+                return;
+            }
+            m_recorder.open(m_recordPath, AV_CODEC_ID_MJPEG, m_v4l2.width(), m_v4l2.height());
+            return;
+        }
+#endif
+        const AVCodecParameters* codecpar = nullptr;
+        if (sourceType == 2) {
+            codecpar = m_replay.codecParameters();
+        } else if (m_formatContext && m_videoStreamIndex >= 0) {
+            codecpar = m_formatContext->streams[m_videoStreamIndex]->codecpar;
+        }
+        if (!codecpar || !m_codecContext) {
+            return;
+        }
+        m_recorder.open(m_recordPath, codecpar->codec_id, m_codecContext->width, m_codecContext->height,
+                        codecpar->extradata, codecpar->extradata_size);
+    }
+
+    void writeArchiveFrame(const cv::Mat& frame) {
+        std::lock_guard<std::mutex> lock(m_archiveMutex);
+        if (!m_archiveRequested) {
+            return;
+        }
+        if (!m_archiveWriter.isOpen() && !m_archiveWriter.open(m_archivePath, frame.cols, frame.rows)) {
+            m_archiveRequested = false;
+            return;
+        }
+        m_archiveWriter.append(frame, m_output.captureTimeUs, m_output.sequence);
+    }
+
+    // 原始画面尺寸：区域解码/裁剪拷贝的帧只覆盖其中一部分
+    cv::Size sourceFrameSize() const {
+#ifdef HAVE_V4L2
+        if (m_useV4l2) {
+            return cv::Size(m_v4l2.width(), m_v4l2.height());
+        }
+#endif
+        if (m_codecContext) {
+            return cv::Size(m_codecContext->width, m_codecContext->height);
+        }
+        return m_output.region.size();
+    }
+
+    // 按 setAutoCrop 的设置重新开始（或停止）自动裁剪，在采集线程中调用
+    void restartAutoCrop() {
+        if (!m_autoCropEnabled) {
+            if (m_cropEstimator.state() != EyeCropEstimator::CROP_IDLE_E) {
+                m_cropEstimator.stop();
+                requestDecodeCrop(m_captureRoi);
+            }
+            return;
+        }
+        cv::Size size = sourceFrameSize();
+        cv::Rect search = m_captureRoi & cv::Rect(0, 0, size.width, size.height);
+        if (search.area() <= 0) {
+            search = cv::Rect(0, 0, size.width, size.height);
+        }
+        m_cropEstimator.start(search, m_autoCropWarmup, m_autoCropMargin);
+        requestDecodeCrop(search);
+    }
+
+    // 在当前帧中取出当前区域的视图（不拷贝），origin 为视图左上角的原始画面坐标
+    cv::Mat cropToCurrentRegion(const cv::Mat& src, cv::Point& origin) {
+        const cv::Rect& region = m_output.region;
+        int scale = std::max(1, m_output.scaleDenom);
+        cv::Rect wanted = m_cropEstimator.state() == EyeCropEstimator::CROP_IDLE_E
+                ? m_captureRoi : m_cropEstimator.crop();
+
+        // 解码侧的区域可能比请求晚一帧生效（预解码队列中的帧），按该帧实际覆盖的区域取交集
+        cv::Rect full(0, 0, src.cols, src.rows);
+        cv::Rect view = full;
+        cv::Rect covered = wanted & region;
+        if (covered.area() > 0) {
+            view = cv::Rect((covered.x - region.x) / scale, (covered.y - region.y) / scale,
+                            covered.width / scale, covered.height / scale) & full;
+            if (view.area() <= 0) {
+                view = full;
+            }
+        }
+
+        origin = region.tl() + view.tl() * scale;
+        {
+            std::lock_guard<std::mutex> lock(m_cropMutex);
+            m_activeCrop = cv::Rect(origin, cv::Size(view.width * scale, view.height * scale));
+        }
+        return view == full ? src : src(view);
+    }
+
+    // 请求解码侧改用新的区域，下一次解码前由解码所在线程生效
+    void requestDecodeCrop(const cv::Rect& crop) {
+        std::lock_guard<std::mutex> lock(m_cropMutex);
+        m_decodeCrop = crop;
+        m_decodeCropChanged = true;
+    }
+
+    void applyPendingDecodeCrop() {
+        std::lock_guard<std::mutex> lock(m_cropMutex);
+        if (!m_decodeCropChanged) {
+            return;
+        }
+        m_decodeCropChanged = false;
+        m_lumaCopyCrop = m_decodeCrop;
+#ifdef HAVE_LIBJPEG_TURBO
+        m_jpegDecoder.setRoi(m_decodeCrop);
+#endif
+#ifdef HAVE_V4L2
+        m_v4l2.setCrop(m_decodeCrop);
+#endif
+    }
+
+    // 参数缓存使用的设备标识：Linux 上解析到设备节点并附带 card/bus_info，
+    // 序号、别名指向同一摄像头时共用一份缓存；其他平台（dshow 设备名）沿用源字符串
+    QString cameraProfileIdentity() const {
+#ifdef HAVE_V4L2
+        std::string device = V4l2Capture::findDevice(m_source.toString().toStdString());
+        if (!device.empty()) {
+            std::string identity = V4l2Capture::deviceIdentity(device);
+            return QString::fromStdString(identity.empty() ? device : identity);
+        }
+#endif
+        return m_source.toString();
+    }
+
+    // 用缓存的参数补全摄像头流信息，省去 avformat_find_stream_info；
+    // 设备报告的编码或分辨率与缓存不符时清除缓存并返回 false，回退到探测
+    bool applyCachedProfile() {
+        m_profileKey = CaptureProfileCache::makeKey("ffmpeg", cameraProfileIdentity(), m_width, m_height, m_fps);
+        CaptureProfile cached;
+        if (!CaptureProfileCache::load(m_profileKey, cached)) {
+            return false;
+        }
+
+        AVStream* stream = nullptr;
+        for (unsigned int i = 0; i < m_formatContext->nb_streams; i++) {
+            if (m_formatContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+                stream = m_formatContext->streams[i];
+                break;
+            }
+        }
+        if (!stream || stream->codecpar->codec_id != cached.codecId
+            || stream->codecpar->width != cached.width || stream->codecpar->height != cached.height) {
+            qDebug() << "摄像头参数与缓存不符，重新探测";
+            CaptureProfileCache::remove(m_profileKey);
+            return false;
+        }
+
+        // MJPEG 的像素格式要解码后才知道，原本由探测得到
+        if (stream->codecpar->format < 0) {
+            stream->codecpar->format = cached.pixelFormat;
+        }
+        if (stream->r_frame_rate.num == 0 && cached.fps > 0) {
+            stream->r_frame_rate = av_d2q(cached.fps, 100000);
+            stream->avg_frame_rate = stream->r_frame_rate;
+        }
+        m_profile = cached;
+        m_profileFromCache = true;
+        qDebug() << "使用缓存的采集参数，跳过流探测:" << avcodec_get_name((AVCodecID)cached.codecId)
+                 << av_get_pix_fmt_name((AVPixelFormat)cached.pixelFormat)
+                 << cached.width << "x" << cached.height << "@" << cached.fps << "fps";
+        return true;
+    }
+
+    // 第一帧解码成功后确认采集参数：与转换上下文不符（缓存的像素格式已过时）时重建上下文，
+    // 摄像头参数写入缓存供下次打开使用
+    void confirmCaptureProfile() {
+        m_profileConfirmed = true;
+
+        AVPixelFormat format = (AVPixelFormat)m_frame->format;
+        if (format != m_swsFormat || m_frame->width != m_swsWidth || m_frame->height != m_swsHeight) {
+            qDebug() << "解码输出" << av_get_pix_fmt_name(format) << m_frame->width << "x" << m_frame->height
+                     << "与预设不符，重建转换上下文";
+            createSwsContext(m_frame->width, m_frame->height, format);
+        }
+
+        if (m_profileKey.isEmpty()) {
+            return;
+        }
+        CaptureProfile profile;
+        profile.codecId = m_codecContext->codec_id;
+        profile.pixelFormat = format;
+        profile.width = m_frame->width;
+        profile.height = m_frame->height;
+        AVRational frameRate = m_formatContext->streams[m_videoStreamIndex]->r_frame_rate;
+        profile.fps = frameRate.den != 0 ? av_q2d(frameRate) : 0;
+        if (!m_profileFromCache || profile != m_profile) {
+            CaptureProfileCache::store(m_profileKey, profile);
+        }
+    }
+
+    bool isUnthrottled() const {
+        return sourceType != 0 && m_replayPace == REPLAY_UNTHROTTLED_E;
+    }
+
+    // 不限速处理结束时的汇总：吞吐、相对录制时长的倍速，以及各级延迟分布
+    void reportRunSummary(int frames, double wallSeconds, int64_t firstCaptureUs, int64_t lastCaptureUs) {
+        double mediaSeconds = 0;
+        if (sourceType == 2 && firstCaptureUs >= 0 && lastCaptureUs > firstCaptureUs) {
+            mediaSeconds = (lastCaptureUs - firstCaptureUs) / 1e6;
+        } else if (m_formatContext && m_formatContext->duration > 0) {
+            mediaSeconds = m_formatContext->duration / (double)AV_TIME_BASE;
+        }
+
+        qDebug() << QString("%1处理完毕:").arg(sourceType == 2 ? "数据包回放" : "视频文件");
+        qDebug() << QString("  - 帧数: %1").arg(frames);
+        qDebug() << QString("  - 耗时: %1 s").arg(wallSeconds, 0, 'f', 2);
+        if (wallSeconds > 0) {
+            qDebug() << QString("  - 吞吐: %1 fps").arg(frames / wallSeconds, 0, 'f', 1);
+            if (mediaSeconds > 0) {
+                qDebug() << QString("  - 相对录制时长: %1x").arg(mediaSeconds / wallSeconds, 0, 'f', 2);
+            }
+        }
+        qDebug().noquote() << metrics().report();
+    }
+
+    // 回放节奏：第一帧建立录制时间与当前时间的对应，之后按录制时间戳等待。
+    // 回到开头或录制中有长时间中断（暂停）时重新对齐
+    void paceReplay(int64_t captureTimeUs) {
+        int64_t nowUs = steadyNowUs();
+        int64_t dueUs = m_replayBaseWallUs + (captureTimeUs - m_replayBaseCaptureUs);
+        if (m_replayBaseCaptureUs < 0 || captureTimeUs < m_replayBaseCaptureUs || dueUs - nowUs > 1000000) {
+            m_replayBaseCaptureUs = captureTimeUs;
+            m_replayBaseWallUs = nowUs;
+            return;
+        }
+        if (dueUs > nowUs) {
+            waitInterruptible(std::chrono::microseconds(dueUs - nowUs));
+        }
+    }
+
+    // 暂停时丢弃一个数据包，按设备帧率阻塞。调用方持有 m_mutex
+    bool discardPausedPacket() {
+#ifdef HAVE_V4L2
+        if (m_useV4l2) {
+            return m_v4l2.discard(1000);
+        }
+#endif
+        if (!m_formatContext || !m_packet) {
+            return false;
+        }
+        int64_t packetTimeUs = 0;
+        int64_t captureTimeUs = 0;
+        if (readPacket(m_packet, packetTimeUs, captureTimeUs) < 0) {
+            return false;
+        }
+        if (m_packet->stream_index == m_videoStreamIndex && m_recorder.isOpen()) {
+            m_recorder.write(m_packet, captureTimeUs);
+        }
+        av_packet_unref(m_packet);
+        m_resumeFlushPending = true;
+        return true;
+    }
+
+    // 暂停后恢复的第一次读取：清掉帧线程解码器里暂停前的在途帧，否则恢复后先输出的是旧帧；
+    // 帧间编码的流还要跳到下一个关键帧，丢过包的参考帧已不完整
+    void flushDecoderAfterPause() {
+        m_resumeFlushPending = false;
+        avcodec_flush_buffers(m_codecContext);
+        m_decodeDelay.clear();
+        const AVCodecDescriptor* descriptor = avcodec_descriptor_get(m_codecContext->codec_id);
+        m_awaitKeyframe = !descriptor || !(descriptor->props & AV_CODEC_PROP_INTRA_ONLY);
+    }
+
+    // 等待采集线程离开 pipe()。线程未启动时立即返回；
+    // 超时只作为异常情况的兜底，正常情况下读取会被中断回调立即打断
+    void waitForCaptureStopped() {
+        if (!m_stateSignal.waitFor([this]() { return !m_captureRunning; }, std::chrono::seconds(2))) {
+            qWarning() << "等待采集线程退出超时";
+        }
+    }
+
+    void handlePauseBufferManagement(){
+        // 🔧 关键：取走并丢弃一帧的数据，保持设备缓冲区为空，恢复后拿到的是最新帧。
+        // 只在数据包/驱动缓冲区层面丢弃，不解码、不转换
+        if (!m_isopened || m_shouldClose) {
+            return;
+        }
+        bool drained = false;
+        if (m_mutex.tryLock()) {
+            drained = discardPausedPacket();
+            m_mutex.unlock();
+        }
+        if (!drained) {
+            waitInterruptible(std::chrono::milliseconds(1));
+            return;
+        }
+
+        m_pauseDrainCount++;
+        // 每隔一段时间输出一次调试信息，避免日志刷屏
+        if (m_pauseDrainCount % 200 == 0) {
+            qDebug() << "🔧 缓冲区清理进行中... 已清理" << m_pauseDrainCount << "帧";
         }
     };
 };
@@ -52,9 +52,10 @@ eyeTrack::~eyeTrack()
         }
     }
 
+    // 先析构管道（停止并回收线程），再释放各级对象
+    delete pip;
     delete cameraPipe;
     delete mergedPip;
-    delete pip;
     delete ui;
 
     qDebug() << "eyeTrack析构完成";
@@ -171,36 +172,37 @@ void eyeTrack::processMergedResult(int frameId, bool success) {
     QElapsedTimer timer;
     timer.start();
 
-    static std::map<int, std::vector<cv::Point2f>> multiFramePredictions;
+    // 跨帧状态保存在本实例中，多个会话互不干扰
+    auto& multiFramePredictions = m_resultState.multiFramePredictions;
 
-    static std::map<int, cv::Point2f> alphaBetaNextFramePredictions;
-    static std::map<int, cv::Point2f> arxNextFramePredictions;
+    auto& alphaBetaNextFramePredictions = m_resultState.alphaBetaNextFramePredictions;
+    auto& arxNextFramePredictions = m_resultState.arxNextFramePredictions;
 
-    static std::map<int, float> alphaBetaPreviousPredictionsX;
-    static std::map<int, float> arxPreviousPredictionsX;
+    auto& alphaBetaPreviousPredictionsX = m_resultState.alphaBetaPreviousPredictionsX;
+    auto& arxPreviousPredictionsX = m_resultState.arxPreviousPredictionsX;
 
-    static std::map<int, float> l2l3PreviousPredictionsX;
-    static std::map<int, float> l1l2PreviousPredictionsX;
-    static std::map<int, float> l1OnlyPreviousPredictionsX;
+    auto& l2l3PreviousPredictionsX = m_resultState.l2l3PreviousPredictionsX;
+    auto& l1l2PreviousPredictionsX = m_resultState.l1l2PreviousPredictionsX;
+    auto& l1OnlyPreviousPredictionsX = m_resultState.l1OnlyPreviousPredictionsX;
 
 
-    static int lastProcessedFrameId = -1;
-    static cv::Point2f lastValidGazePoint(960.0f, 540.0f);
-    static cv::Point2f lastKnownGoodGazePoint(960.0f, 540.0f);
-    static bool hasValidHistory = false;
-    static int totalProcessedFrames = 0;
+    int& lastProcessedFrameId = m_resultState.lastProcessedFrameId;
+    cv::Point2f& lastValidGazePoint = m_resultState.lastValidGazePoint;
+    cv::Point2f& lastKnownGoodGazePoint = m_resultState.lastKnownGoodGazePoint;
+    bool& hasValidHistory = m_resultState.hasValidHistory;
+    int& totalProcessedFrames = m_resultState.totalProcessedFrames;
 
-    // 眼震检测相关静态变量
-    static int nystagmusPeakCount = 0;
-    static cv::Point2f lastGazeDirection(0, 0);
-    static int directionReversalCount = 0;
-    static std::deque<float> velocityHistory;
+    // 眼震检测相关状态
+    int& nystagmusPeakCount = m_resultState.nystagmusPeakCount;
+    cv::Point2f& lastGazeDirection = m_resultState.lastGazeDirection;
+    int& directionReversalCount = m_resultState.directionReversalCount;
+    std::deque<float>& velocityHistory = m_resultState.velocityHistory;
     static const int VELOCITY_HISTORY_SIZE = 10;
 
 
     // 预测来源追踪
-    static std::map<int, int> predictionSourceFrame;
-    static std::map<int, cv::Point2f> frameGazePoints;
+    auto& predictionSourceFrame = m_resultState.predictionSourceFrame;
+    auto& frameGazePoints = m_resultState.frameGazePoints;
 
     totalProcessedFrames++;
 
@@ -917,7 +919,12 @@ void eyeTrack::processMergedResult(int frameId, bool success) {
 
 void eyeTrack::drawParallelMarkersAndDisplay(cv::Mat& rgbImage, FrameData *frameData, int frameId)
 {
-    cv::Mat originalCopy = rgbImage.clone();
+    // 原图副本只在保存数据时需要，避免每帧一次整帧拷贝
+    const bool saveImages = dataFlag;
+    cv::Mat originalCopy;
+    if (saveImages) {
+        originalCopy = rgbImage.clone();
+    }
 
     // 绘制光斑（与原版保持一致）
     for(size_t i = 0; i < frameData->lightPoints.size(); ++i) {
@@ -963,7 +970,7 @@ void eyeTrack::drawParallelMarkersAndDisplay(cv::Mat& rgbImage, FrameData *frame
     ui->displayLabel->setPixmap(centeredPixmap);
 
     // 保存图像
-    if(dataFlag) {
+    if(saveImages) {
         imageSave.addDisplayImageToBuffer(rgbImage,frameId);
         imageSave.addOriginalImageToBuffer(originalCopy,frameId);
     }
@@ -1063,6 +1070,9 @@ void eyeTrack::SaveCollectingData() {
         qDebug() << "最后一帧数据:" << last->second.x << "," << last->second.y;
     }
 
+    // 同时导出管道各级延迟分布，便于对照预测数据分析尾延迟
+    pip->dumpMetrics(QDir::currentPath() + "/pipeline_metrics.csv");
+
     QString fileName = QDir::currentPath() + "/prediction_only_data.csv";
     qDebug() << "保存路径:" << fileName;
 
@@ -15,6 +15,8 @@
 #include "spotextractionpip.h"
 #include "gazeukf.h"
 #include <QTextEdit>
+#include <deque>
+#include <map>
 #include "datesave.h"
 #include "improvegazeukf.h"
 #include "nystagmuadaptiveukf.h"
@@ -222,6 +224,37 @@ private:
     pipline *pip;
     videoCapturePip* cameraPipe;  // 保留视频采集
 
+    // processMergedResult 的跨帧状态，每个会话独立（原为函数内静态变量）
+    struct MergedResultState {
+        std::map<int, std::vector<cv::Point2f>> multiFramePredictions;
+
+        std::map<int, cv::Point2f> alphaBetaNextFramePredictions;
+        std::map<int, cv::Point2f> arxNextFramePredictions;
+
+        std::map<int, float> alphaBetaPreviousPredictionsX;
+        std::map<int, float> arxPreviousPredictionsX;
+
+        std::map<int, float> l2l3PreviousPredictionsX;
+        std::map<int, float> l1l2PreviousPredictionsX;
+        std::map<int, float> l1OnlyPreviousPredictionsX;
+
+        int lastProcessedFrameId = -1;
+        cv::Point2f lastValidGazePoint = cv::Point2f(960.0f, 540.0f);
+        cv::Point2f lastKnownGoodGazePoint = cv::Point2f(960.0f, 540.0f);
+        bool hasValidHistory = false;
+        int totalProcessedFrames = 0;
+
+        // 眼震检测
+        int nystagmusPeakCount = 0;
+        cv::Point2f lastGazeDirection = cv::Point2f(0, 0);
+        int directionReversalCount = 0;
+        std::deque<float> velocityHistory;
+
+        // 预测来源追踪
+        std::map<int, int> predictionSourceFrame;
+        std::map<int, cv::Point2f> frameGazePoints;
+    } m_resultState;
+
     SystemState currentState = STOPPED;  // 明确初始状态
 
     bool cameraFlag = false;
@@ -460,6 +460,7 @@ void fixationTest::on_pushButton_last_clicked()
 
 FixationTest::~FixationTest()
 {
+    // 先析构管道（停止并回收线程），再释放各级对象
     delete pip;
     delete cameraPipe;
     delete mergedPip;
@@ -480,6 +481,7 @@ FixationTest::FixationTest(QWidget *parent)
         m_RoiIndex[i] = i;
     }
 
+    pip = new pipline;
     cameraPipe = new videoCapturePip;
     mergedPip  = new MergedProcessingPip;
 
@@ -237,6 +237,7 @@ TianDistortionTest::TianDistortionTest(QWidget *parent)
 
 TianDistortionTest::~TianDistortionTest()
 {
+    // 先析构管道（停止并回收线程），再释放各级对象
     delete pip;
     delete cameraPipe;
 